@@ -69,8 +69,28 @@ fn static_link(out_dir: &str, target: &str) {
     cfgs.file("./lib/app.cpp")
         .file("./lib/browser.cpp")
         .file("./lib/control.cpp")
+        .file("./lib/input_queue.cpp")
+        .file("./lib/input_replayer.cpp")
+        .file("./lib/keyboard_state.cpp")
+        .file("./lib/key_map.cpp")
         .file("./lib/bridge.cpp")
+        .file("./lib/shared_message.cpp")
+        .file("./lib/pending_calls.cpp")
         .file("./lib/render.cpp")
+        .file("./lib/render_metrics.cpp")
+        .file("./lib/input_tracer.cpp")
+        .file("./lib/histogram.cpp")
+        .file("./lib/frame_store.cpp")
+        .file("./lib/frame_ring.cpp")
+        .file("./lib/frame_rate.cpp")
+        .file("./lib/change_filter.cpp")
+        .file("./lib/frame_converter.cpp")
+        .file("./lib/frame_output.cpp")
+        .file("./lib/popup_compositor.cpp")
+        .file("./lib/tile_surface.cpp")
+        .file("./lib/simd.cpp")
+        .file("./lib/recorder.cpp")
+        .file("./lib/recording.cpp")
         .file("./lib/display.cpp")
         .file("./lib/webview.cpp")
         .file("./lib/scheme_handler.cpp")
@@ -0,0 +1,179 @@
+//! replays an input log against a page and reports how the render path kept
+//! up, once per run. the log is recorded with `Browser::start_input_recording`
+//! or `Browser::start_recording`, local pages can be served from a directory
+//! with the custom scheme.
+//!
+//! replay_bench <url> <input log> [--fast] [--runs N] [--scheme DIR]
+
+use std::{env::args, time::Duration};
+
+use tokio::{
+    runtime::Runtime,
+    sync::mpsc::{unbounded_channel, UnboundedSender},
+    time::{sleep, Instant},
+};
+use webview::{
+    execute_subprocess, is_subprocess, App, AppSettings, BrowserSettings, BrowserState,
+    HistogramStats, KeyboardLayout, Observer, PixelFormat, HWND,
+};
+
+const FRAME_RATE: u32 = 60;
+// how long frames are still counted after the last event was sent.
+const TAIL: Duration = Duration::from_millis(500);
+
+struct BrowserObserver {
+    loaded: UnboundedSender<()>,
+}
+
+impl Observer for BrowserObserver {
+    fn on_state_change(&self, state: BrowserState) {
+        if state == BrowserState::Load {
+            let _ = self.loaded.send(());
+        }
+    }
+}
+
+struct Options {
+    url: String,
+    path: String,
+    is_realtime: bool,
+    runs: u32,
+    scheme_path: Option<String>,
+}
+
+fn parse_options() -> Option<Options> {
+    let args = args().skip(1).collect::<Vec<_>>();
+    let mut options = Options {
+        url: args.get(0)?.clone(),
+        path: args.get(1)?.clone(),
+        is_realtime: true,
+        runs: 1,
+        scheme_path: None,
+    };
+
+    let mut iter = args.iter().skip(2);
+    while let Some(arg) = iter.next() {
+        match arg.as_str() {
+            "--fast" => options.is_realtime = false,
+            "--runs" => options.runs = iter.next()?.parse().ok()?,
+            "--scheme" => options.scheme_path = Some(iter.next()?.clone()),
+            _ => return None,
+        }
+    }
+
+    Some(options)
+}
+
+fn ms(ns: u64) -> f64 {
+    ns as f64 / 1e6
+}
+
+fn print_latency(name: &str, stats: &HistogramStats) {
+    println!(
+        "  {:<14} p50 {:>7.2} ms  p99 {:>7.2} ms  max {:>7.2} ms  ({} samples)",
+        name,
+        ms(stats.p50),
+        ms(stats.p99),
+        ms(stats.max),
+        stats.count
+    );
+}
+
+async fn run(options: Options) -> anyhow::Result<()> {
+    let app = App::new(&AppSettings {
+        cache_path: None,
+        browser_subprocess_path: None,
+        scheme_path: options.scheme_path.as_deref(),
+    })
+    .await?;
+
+    let settings = BrowserSettings {
+        url: &options.url,
+        frame_rate: FRAME_RATE,
+        width: 1280,
+        height: 720,
+        device_scale_factor: 1.0,
+        is_offscreen: true,
+        // frames are pulled like a compositor would, so that frames the host
+        // was too slow for show up as dropped.
+        frame_store: true,
+        change_filter: false,
+        output_format: PixelFormat::BGRA,
+        straight_alpha: false,
+        frame_ring_slots: 0,
+        adaptive_frame_rate: false,
+        external_begin_frame: false,
+        tiled_output: false,
+        auto_hide_intervals: 0,
+        coalesce_input: false,
+        keyboard_layout: KeyboardLayout::US,
+        trace_input: true,
+        window_handle: HWND::default(),
+    };
+
+    for run in 1..=options.runs {
+        // a fresh browser per run, so every run starts from the same page.
+        let (loaded, mut on_loaded) = unbounded_channel();
+        let browser = app
+            .create_browser(&settings, BrowserObserver { loaded })
+            .await?;
+
+        on_loaded.recv().await;
+        sleep(Duration::from_secs(1)).await;
+
+        browser.render_stats(true);
+        if !browser.start_replay(&options.path, options.is_realtime) {
+            anyhow::bail!("can not read {}", options.path);
+        }
+
+        let interval = Duration::from_millis(1000 / FRAME_RATE as u64);
+        let start = Instant::now();
+        let mut finished = None;
+        loop {
+            drop(browser.acquire_frame());
+            sleep(interval).await;
+
+            if browser.is_replaying() {
+                continue;
+            }
+
+            // the frames painted for the last events still count.
+            if finished.get_or_insert_with(Instant::now).elapsed() >= TAIL {
+                break;
+            }
+        }
+
+        let duration = finished.unwrap_or(start) - start;
+        let stats = browser.render_stats(true);
+        let input = browser.input_stats(true);
+        println!("run {}: replayed in {:.3} s", run, duration.as_secs_f64());
+        println!(
+            "  frames         {} painted, {} delivered, {} dropped, {:.1} fps",
+            stats.painted,
+            stats.delivered,
+            stats.dropped,
+            stats.delivered as f64 / start.elapsed().as_secs_f64()
+        );
+
+        print_latency("input queue", &input.queue_delay);
+        print_latency("input to frame", &stats.input_latency);
+        print_latency("input to paint", &stats.input_to_paint);
+        print_latency("input to host", &stats.input_to_delivered);
+        print_latency("paint interval", &stats.paint_interval);
+    }
+
+    Ok(())
+}
+
+fn main() -> anyhow::Result<()> {
+    if is_subprocess() {
+        execute_subprocess();
+    }
+
+    let Some(options) = parse_options() else {
+        eprintln!("usage: replay_bench <url> <input log> [--fast] [--runs N] [--scheme DIR]");
+        std::process::exit(2);
+    };
+
+    Runtime::new()?.block_on(run(options))
+}
@@ -8,8 +8,8 @@ use std::{
 use minifb::{MouseButton, MouseMode, Window, WindowOptions};
 use tokio::runtime::Runtime;
 use webview::{
-    execute_subprocess, is_subprocess, ActionState, App, AppSettings, BrowserSettings, MouseAction,
-    MouseButtons, Observer, Position, HWND,
+    execute_subprocess, is_subprocess, ActionState, App, AppSettings, BrowserSettings,
+    KeyboardLayout, MouseAction, MouseButtons, Observer, PixelFormat, Position, HWND,
 };
 
 struct BrowserObserver {
@@ -38,6 +38,18 @@ async fn run_cef() -> anyhow::Result<()> {
         height: 600,
         device_scale_factor: 1.0,
         is_offscreen: true,
+        frame_store: false,
+        change_filter: false,
+        output_format: PixelFormat::BGRA,
+        straight_alpha: false,
+        frame_ring_slots: 0,
+        adaptive_frame_rate: false,
+        external_begin_frame: false,
+        tiled_output: false,
+        auto_hide_intervals: 0,
+        coalesce_input: false,
+        keyboard_layout: KeyboardLayout::US,
+        trace_input: false,
         window_handle: HWND(null()),
     };
 
@@ -55,6 +55,7 @@ CefRefPtr<IBrowser> IApp::CreateBrowser(BrowserSettings* settings,
     if (settings->is_offscreen)
     {
         window_info.SetAsWindowless((CefWindowHandle)(settings->window_handle));
+        window_info.external_begin_frame_enabled = settings->external_begin_frame;
     }
     else
     {
@@ -7,11 +7,49 @@
 
 #include "bridge.h"
 
+#include "include/base/cef_callback.h"
+#include "include/wrapper/cef_closure_task.h"
+
 using namespace std::placeholders;
 
+static inline std::vector<uint8_t> to_bytes(const std::string& str)
+{
+    return std::vector<uint8_t>(str.begin(), str.end());
+}
+
+// CefBinaryValue can not be empty, an empty payload is sent as null.
+static inline void set_bytes(CefRefPtr<CefListValue> args,
+                             size_t index,
+                             const void* data,
+                             size_t size)
+{
+    if (size == 0)
+    {
+        args->SetNull(index);
+    }
+    else
+    {
+        args->SetBinary(index, CefBinaryValue::Create(data, size));
+    }
+}
+
+static inline std::vector<uint8_t> get_bytes(CefRefPtr<CefListValue> args, size_t index)
+{
+    std::vector<uint8_t> bytes;
+    if (args->GetType(index) != VTYPE_BINARY)
+    {
+        return bytes;
+    }
+
+    CefRefPtr<CefBinaryValue> value = args->GetBinary(index);
+    bytes.resize(value->GetSize());
+    value->GetData(bytes.data(), bytes.size(), 0);
+    return bytes;
+}
+
 /* ================= MessageTransPort =======================*/
 
-void MessageTransPort::Call(const std::string& req, Handler handler)
+void MessageTransPort::Call(const std::string& req, Handler handler, uint32_t timeout_ms)
 {
     if (_is_closed)
     {
@@ -26,18 +64,54 @@ void MessageTransPort::Call(const std::string& req, Handler handler)
     }
 
     auto seq = _GetSeqNumber();
-    auto msg = CefProcessMessage::Create("__inner_call_request");
-    CefRefPtr<CefListValue> args = msg->GetArgumentList();
-    args->SetSize(2);
-    args->SetString(0, req);
-    args->SetInt(1, seq);
+    _AddPendingCall(PendingCall{ seq, PendingCalls::Now() + timeout_ms, handler, nullptr });
 
-    auto pid = _is_master ? PID_RENDERER : PID_BROWSER;
-    _browser.value()->GetMainFrame()->SendProcessMessage(pid, msg);
+    auto msg = SharedMessage::Create("__inner_call_request", seq, false, req.data(), req.size());
+    if (!msg)
+    {
+        msg = CefProcessMessage::Create("__inner_call_request");
+        CefRefPtr<CefListValue> args = msg->GetArgumentList();
+        args->SetSize(2);
+        args->SetString(0, req);
+        args->SetInt(1, seq);
+    }
+
+    _SendMessage(msg);
+}
+
+void MessageTransPort::CallBinary(const void* req,
+                                  size_t size,
+                                  BinaryHandler handler,
+                                  uint32_t timeout_ms)
+{
+    if (_is_closed)
+    {
+        auto err = to_bytes(CLOSED_ERR);
+        handler(err, true);
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        auto err = to_bytes(NOT_HANDLER_ERR);
+        handler(err, true);
+        return;
+    }
+
+    auto seq = _GetSeqNumber();
+    _AddPendingCall(PendingCall{ seq, PendingCalls::Now() + timeout_ms, nullptr, handler });
 
-    _mutex.lock();
-    _call_table.insert({ seq, handler });
-    _mutex.unlock();
+    auto msg = SharedMessage::Create("__inner_binary_call_request", seq, false, req, size);
+    if (!msg)
+    {
+        msg = CefProcessMessage::Create("__inner_binary_call_request");
+        CefRefPtr<CefListValue> args = msg->GetArgumentList();
+        args->SetSize(2);
+        set_bytes(args, 0, req, size);
+        args->SetInt(1, seq);
+    }
+
+    _SendMessage(msg);
 }
 
 bool MessageTransPort::OnMessage(CefRefPtr<CefProcessMessage> msg)
@@ -48,22 +122,62 @@ bool MessageTransPort::OnMessage(CefRefPtr<CefProcessMessage> msg)
     }
 
     std::string kind_name = msg->GetName();
-    CefRefPtr<CefListValue> args = msg->GetArgumentList();
-    int seq_id = args->GetInt(args->GetSize() - 1);
+    if (kind_name != "__inner_call_request"
+        && kind_name != "__inner_call_response"
+        && kind_name != "__inner_binary_call_request"
+        && kind_name != "__inner_binary_call_response")
+    {
+        return false;
+    }
 
-    if (kind_name == "__inner_call_request")
+    // large payloads come in shared memory, which has no argument list. a
+    // region that does not hold a whole message is dropped.
+    SharedMessage shared;
+    bool is_shared = shared.Read(msg);
+    if (!is_shared && msg->GetSharedMemoryRegion())
     {
-        _HandleCallRequest(args, seq_id);
         return true;
     }
 
-    if (kind_name == "__inner_call_response")
+    CefRefPtr<CefListValue> args = is_shared ? nullptr : msg->GetArgumentList();
+    if (!is_shared)
     {
-        _HandleCallResponse(args, seq_id);
-        return true;
+        // requests carry the payload and the sequence id, responses carry the
+        // error flag in front of them.
+        bool is_request =
+            kind_name == "__inner_call_request" || kind_name == "__inner_binary_call_request";
+        if (!args || args->GetSize() != (is_request ? 2 : 3))
+        {
+            return true;
+        }
     }
 
-    return false;
+    int seq_id = is_shared ? shared.SeqId() : args->GetInt(args->GetSize() - 1);
+
+    if (kind_name == "__inner_call_request")
+    {
+        std::string req = is_shared ? shared.String() : args->GetString(0).ToString();
+        _HandleCallRequest(req, seq_id);
+    }
+    else if (kind_name == "__inner_call_response")
+    {
+        bool is_err = is_shared ? shared.IsErr() : args->GetBool(0);
+        std::string res = is_shared ? shared.String() : args->GetString(1).ToString();
+        _HandleCallResponse(res, is_err, seq_id);
+    }
+    else if (kind_name == "__inner_binary_call_request")
+    {
+        std::vector<uint8_t> req = is_shared ? shared.Bytes() : get_bytes(args, 0);
+        _HandleBinaryCallRequest(req, seq_id);
+    }
+    else
+    {
+        bool is_err = is_shared ? shared.IsErr() : args->GetBool(0);
+        std::vector<uint8_t> res = is_shared ? shared.Bytes() : get_bytes(args, 1);
+        _HandleBinaryCallResponse(res, is_err, seq_id);
+    }
+
+    return true;
 }
 
 void MessageTransPort::On(OnHandler handler)
@@ -74,23 +188,108 @@ void MessageTransPort::On(OnHandler handler)
     }
 }
 
+void MessageTransPort::OnBinary(OnBinaryHandler handler)
+{
+    if (!_is_closed)
+    {
+        _on_binary_handler = handler;
+    }
+}
+
 void MessageTransPort::IClose()
 {
     _is_closed = true;
     _browser = std::nullopt;
     _on_handler = std::nullopt;
+    _on_binary_handler = std::nullopt;
+
+    // the callers still wait for these, they get the error now.
+    std::vector<PendingCall> calls;
+    _pending_calls.TakeAll(calls);
+    for (auto& call : calls)
+    {
+        _FailCall(call, CLOSED_ERR);
+    }
 }
 
 int MessageTransPort::_GetSeqNumber()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    return (int)(_seq.fetch_add(1, std::memory_order_relaxed) & INT_MAX);
+}
+
+void MessageTransPort::_AddPendingCall(PendingCall call)
+{
+    _pending_calls.Insert(std::move(call));
+    _ScheduleExpire();
+}
+
+void MessageTransPort::_ScheduleExpire()
+{
+    if (_is_expire_scheduled.exchange(true))
+    {
+        return;
+    }
+
+    // responses arrive on this thread, so a call is answered or expired on
+    // the same thread.
+    auto thread = _is_master ? TID_UI : TID_RENDERER;
+    CefPostDelayedTask(thread,
+                       base::BindOnce(&MessageTransPort::_OnExpire, weak_from_this()),
+                       PENDING_CALLS_TICK_MS);
+}
 
-    int number = _seq;
-    _seq = _seq == INT_MAX ? 0 : _seq + 1;
-    return number;
+void MessageTransPort::_OnExpire(std::weak_ptr<MessageTransPort> weak)
+{
+    if (auto transport = weak.lock())
+    {
+        transport->_Expire();
+    }
 }
 
-void MessageTransPort::_HandleCallRequest(CefRefPtr<CefListValue> args, int seq_id)
+void MessageTransPort::_Expire()
+{
+    if (_is_closed)
+    {
+        return;
+    }
+
+    std::vector<PendingCall> expired;
+    bool has_pending = _pending_calls.Expire(PendingCalls::Now(), expired);
+    for (auto& call : expired)
+    {
+        _FailCall(call, TIMEOUT_ERR);
+    }
+
+    _is_expire_scheduled = false;
+
+    // a call added after the table was found empty saw the task still
+    // scheduled and did not post another one.
+    if (has_pending || _pending_calls.Size() > 0)
+    {
+        _ScheduleExpire();
+    }
+}
+
+void MessageTransPort::_FailCall(PendingCall& call, std::string& err)
+{
+    if (call.handler)
+    {
+        call.handler(err, true);
+    }
+    else if (call.binary_handler)
+    {
+        auto bytes = to_bytes(err);
+        call.binary_handler(bytes, true);
+    }
+}
+
+void MessageTransPort::_SendMessage(CefRefPtr<CefProcessMessage> msg)
+{
+    auto pid = _is_master ? PID_RENDERER : PID_BROWSER;
+    _browser.value()->GetMainFrame()->SendProcessMessage(pid, msg);
+}
+
+void MessageTransPort::_HandleCallRequest(std::string& req, int seq_id)
 {
     if (_is_closed)
     {
@@ -103,29 +302,26 @@ void MessageTransPort::_HandleCallRequest(CefRefPtr<CefListValue> args, int seq_
         return;
     }
 
-    std::string req = args->GetString(0);
     _on_handler.value()(
         req, [=](std::string& res, bool is_err) { _OnHandleCallback(res, is_err, seq_id); });
 }
 
-void MessageTransPort::_HandleCallResponse(CefRefPtr<CefListValue> args, int seq_id)
+void MessageTransPort::_HandleCallResponse(std::string& res, bool is_err, int seq_id)
 {
     if (_is_closed)
     {
         return;
     }
 
-    bool is_err = args->GetBool(0);
-    std::string res = args->GetString(1);
-    auto iter = _call_table.find(seq_id);
-    if (iter == _call_table.end())
+    // taken under the lock of its shard, a call that expires at the same time
+    // is only answered once.
+    PendingCall call;
+    if (!_pending_calls.Take(seq_id, call) || !call.handler)
     {
         return;
     }
 
-    std::pair<int, Handler> kv = *iter;
-    kv.second(res, is_err);
-    _call_table.erase(iter);
+    call.handler(res, is_err);
 }
 
 void MessageTransPort::_OnHandleCallback(std::string& res, bool is_err, int seq_id)
@@ -140,15 +336,81 @@ void MessageTransPort::_OnHandleCallback(std::string& res, bool is_err, int seq_
         return;
     }
 
-    auto msg = CefProcessMessage::Create("__inner_call_response");
-    CefRefPtr<CefListValue> args = msg->GetArgumentList();
-    args->SetSize(3);
-    args->SetBool(0, is_err);
-    args->SetString(1, res);
-    args->SetInt(2, seq_id);
+    auto msg = SharedMessage::Create(
+        "__inner_call_response", seq_id, is_err, res.data(), res.size());
+    if (!msg)
+    {
+        msg = CefProcessMessage::Create("__inner_call_response");
+        CefRefPtr<CefListValue> args = msg->GetArgumentList();
+        args->SetSize(3);
+        args->SetBool(0, is_err);
+        args->SetString(1, res);
+        args->SetInt(2, seq_id);
+    }
+
+    _SendMessage(msg);
+}
 
-    auto pid = _is_master ? PID_RENDERER : PID_BROWSER;
-    _browser.value()->GetMainFrame()->SendProcessMessage(pid, msg);
+void MessageTransPort::_HandleBinaryCallRequest(std::vector<uint8_t>& req, int seq_id)
+{
+    if (_is_closed)
+    {
+        return;
+    }
+
+    if (!_on_binary_handler.has_value())
+    {
+        auto err = to_bytes(NOT_HANDLER_ERR);
+        _OnHandleBinaryCallback(err, true, seq_id);
+        return;
+    }
+
+    _on_binary_handler.value()(req, [=](std::vector<uint8_t>& res, bool is_err) {
+        _OnHandleBinaryCallback(res, is_err, seq_id);
+    });
+}
+
+void MessageTransPort::_HandleBinaryCallResponse(std::vector<uint8_t>& res, bool is_err, int seq_id)
+{
+    if (_is_closed)
+    {
+        return;
+    }
+
+    PendingCall call;
+    if (!_pending_calls.Take(seq_id, call) || !call.binary_handler)
+    {
+        return;
+    }
+
+    call.binary_handler(res, is_err);
+}
+
+void MessageTransPort::_OnHandleBinaryCallback(std::vector<uint8_t>& res, bool is_err, int seq_id)
+{
+    if (_is_closed)
+    {
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        return;
+    }
+
+    auto msg = SharedMessage::Create(
+        "__inner_binary_call_response", seq_id, is_err, res.data(), res.size());
+    if (!msg)
+    {
+        msg = CefProcessMessage::Create("__inner_binary_call_response");
+        CefRefPtr<CefListValue> args = msg->GetArgumentList();
+        args->SetSize(3);
+        args->SetBool(0, is_err);
+        set_bytes(args, 1, res.data(), res.size());
+        args->SetInt(2, seq_id);
+    }
+
+    _SendMessage(msg);
 }
 
 /* ================= IpcSendProcesser =======================*/
@@ -325,6 +587,12 @@ void BridgeCallProcesser::_HandleCallback(CefRefPtr<CefV8Value> callback,
                                           std::string& res,
                                           bool is_err)
 {
+    // an expired or closed call can be failed after the page went away.
+    if (!context->IsValid())
+    {
+        return;
+    }
+
     context->Enter();
     CefV8ValueList arguments;
 
@@ -337,6 +605,206 @@ void BridgeCallProcesser::_HandleCallback(CefRefPtr<CefV8Value> callback,
     context->Exit();
 }
 
+/* ================= BridgeBuffer =======================*/
+
+CefRefPtr<CefV8Value> BridgeBuffer::Create(std::vector<uint8_t> data)
+{
+    CefRefPtr<BridgeBuffer> buffer = new BridgeBuffer(std::move(data));
+    return CefV8Value::CreateArrayBuffer((void*)buffer->_data.data(), buffer->_data.size(), buffer);
+}
+
+BridgeBuffer* BridgeBuffer::From(CefRefPtr<CefV8Value> value)
+{
+    if (!value->IsArrayBuffer())
+    {
+        return nullptr;
+    }
+
+    return dynamic_cast<BridgeBuffer*>(value->GetArrayBufferReleaseCallback().get());
+}
+
+/* ================= BridgeAllocProcesser =======================*/
+
+bool BridgeAllocProcesser::Execute(const CefString& name,
+                                   CefRefPtr<CefV8Value> object,
+                                   const CefV8ValueList& arguments,
+                                   CefRefPtr<CefV8Value>& retval,
+                                   CefString& exception)
+{
+    if (arguments.size() != 1)
+    {
+        return false;
+    }
+
+    if (!arguments[0]->IsUInt())
+    {
+        return false;
+    }
+
+    uint32_t size = arguments[0]->GetUIntValue();
+    if (size > BRIDGE_ALLOC_MAX_SIZE)
+    {
+        exception = "size is larger than the 64 MiB native.bridge.alloc allows";
+        return true;
+    }
+
+    retval = BridgeBuffer::Create(std::vector<uint8_t>(size));
+    return true;
+}
+
+/* ================= BridgeBinaryCallbacker =======================*/
+
+bool BridgeBinaryCallbacker::Execute(const CefString& name_,
+                                     CefRefPtr<CefV8Value> object,
+                                     const CefV8ValueList& arguments,
+                                     CefRefPtr<CefV8Value>& retval,
+                                     CefString& exception)
+{
+    if (arguments.size() != 2)
+    {
+        return false;
+    }
+
+    if (!arguments[0]->IsBool())
+    {
+        return false;
+    }
+
+    // an error can be given as a string, a response has to be a buffer of the
+    // bridge.
+    bool is_err = arguments[0]->GetBoolValue();
+    std::vector<uint8_t> res;
+    if (arguments[1]->IsString())
+    {
+        res = to_bytes(arguments[1]->GetStringValue());
+    }
+    else if (BridgeBuffer* buffer = BridgeBuffer::From(arguments[1]))
+    {
+        res = buffer->Data();
+    }
+    else
+    {
+        exception = "response must be a string or an ArrayBuffer from native.bridge.alloc";
+        return true;
+    }
+
+    _handler(res, is_err);
+    retval = CefV8Value::CreateUndefined();
+    return true;
+}
+
+/* ================= BridgeOnBinaryProcesser =======================*/
+
+bool BridgeOnBinaryProcesser::Execute(const CefString& name_,
+                                      CefRefPtr<CefV8Value> object,
+                                      const CefV8ValueList& arguments,
+                                      CefRefPtr<CefV8Value>& retval,
+                                      CefString& exception)
+{
+    if (arguments.size() < 1)
+    {
+        return false;
+    }
+
+    if (!arguments[0]->IsFunction())
+    {
+        return false;
+    }
+
+    CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+    CefRefPtr<CefV8Value> callback = arguments[0];
+
+    _transport->OnBinary(
+        [=](std::vector<uint8_t>& req, MessageTransPort::BinaryHandler handler) {
+            _HandleOnCallback(context, callback, req, handler);
+        });
+
+    retval = CefV8Value::CreateUndefined();
+    return true;
+}
+
+void BridgeOnBinaryProcesser::_HandleOnCallback(CefRefPtr<CefV8Context> context,
+                                                CefRefPtr<CefV8Value> callback,
+                                                std::vector<uint8_t>& req,
+                                                MessageTransPort::BinaryHandler handler)
+{
+    context->Enter();
+    CefV8ValueList arguments;
+    arguments.push_back(BridgeBuffer::Create(std::move(req)));
+    arguments.push_back(
+        CefV8Value::CreateFunction("callback", new BridgeBinaryCallbacker(handler)));
+    callback->ExecuteFunction(nullptr, arguments);
+    context->Exit();
+}
+
+/* ================= BridgeCallBinaryProcesser =======================*/
+
+bool BridgeCallBinaryProcesser::Execute(const CefString& name,
+                                        CefRefPtr<CefV8Value> object,
+                                        const CefV8ValueList& arguments,
+                                        CefRefPtr<CefV8Value>& retval,
+                                        CefString& exception)
+{
+    if (arguments.size() != 2)
+    {
+        return false;
+    }
+
+    if (!arguments[1]->IsFunction())
+    {
+        return false;
+    }
+
+    BridgeBuffer* buffer = BridgeBuffer::From(arguments[0]);
+    if (buffer == nullptr)
+    {
+        exception = "request must be an ArrayBuffer from native.bridge.alloc";
+        return true;
+    }
+
+    CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+    CefRefPtr<CefV8Value> callback = arguments[1];
+
+    auto& req = buffer->Data();
+    _transport->CallBinary(
+        req.data(), req.size(), [=](std::vector<uint8_t>& res, bool is_err) {
+            _HandleCallback(callback, context, res, is_err);
+        });
+
+    retval = CefV8Value::CreateUndefined();
+    return true;
+}
+
+void BridgeCallBinaryProcesser::_HandleCallback(CefRefPtr<CefV8Value> callback,
+                                                CefRefPtr<CefV8Context> context,
+                                                std::vector<uint8_t>& res,
+                                                bool is_err)
+{
+    // an expired or closed call can be failed after the page went away.
+    if (!context->IsValid())
+    {
+        return;
+    }
+
+    context->Enter();
+    CefV8ValueList arguments;
+
+    auto nul = CefV8Value::CreateNull();
+    if (is_err)
+    {
+        arguments.push_back(CefV8Value::CreateString(std::string(res.begin(), res.end())));
+        arguments.push_back(nul);
+    }
+    else
+    {
+        arguments.push_back(nul);
+        arguments.push_back(BridgeBuffer::Create(std::move(res)));
+    }
+
+    callback->ExecuteFunction(nullptr, arguments);
+    context->Exit();
+}
+
 /* ================= IBridgeHost =======================*/
 
 #define CREATE_FUNC(name, func) \
@@ -351,6 +819,9 @@ void IBridgeHost::OnContextCreated(CefRefPtr<CefBrowser> browser,
     CefRefPtr<CefV8Value> bridge = CefV8Value::CreateObject(nullptr, nullptr);
     bridge->SetValue(CREATE_FUNC("call", _bridge_call));
     bridge->SetValue(CREATE_FUNC("on", _bridge_on));
+    bridge->SetValue(CREATE_FUNC("callBinary", _bridge_call_binary));
+    bridge->SetValue(CREATE_FUNC("onBinary", _bridge_on_binary));
+    bridge->SetValue(CREATE_FUNC("alloc", _bridge_alloc));
 
     CefRefPtr<CefV8Value> ipc = CefV8Value::CreateObject(nullptr, nullptr);
     ipc->SetValue(CREATE_FUNC("send", _ipc_send));
@@ -411,6 +882,9 @@ void IBridgeMaster::SetBrowser(CefRefPtr<CefBrowser> browser)
     _transport->SetBrowser(browser);
     _transport->On(
         [&](std::string& req, MessageTransPort::Handler handler) { _HandleOn(req, handler); });
+    _transport->OnBinary([&](std::vector<uint8_t>& req, MessageTransPort::BinaryHandler handler) {
+        _HandleOnBinary(req, handler);
+    });
 
     auto id = _browser.value()->GetIdentifier();
     _router_master = std::make_shared<MessageRouterMaster>(id, _router);
@@ -439,6 +913,30 @@ void IBridgeMaster::BridgeCall(char* req, BridgeCallCallback callback, void* ctx
                      });
 }
 
+void IBridgeMaster::BridgeCallBinary(const uint8_t* req,
+                                     size_t size,
+                                     BridgeBinaryCallCallback callback,
+                                     void* ctx)
+{
+    assert(callback);
+
+    if (_is_closed)
+    {
+        callback(nullptr, 0, true, ctx);
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        callback(nullptr, 0, true, ctx);
+        return;
+    }
+
+    _transport->CallBinary(req, size, [=](std::vector<uint8_t>& res, bool is_err) {
+        callback(res.data(), res.size(), is_err, ctx);
+    });
+}
+
 void IBridgeMaster::BridgeSetOnCallback(BridgeOnHandler handler, void* ctx)
 {
     assert(handler);
@@ -452,10 +950,25 @@ void IBridgeMaster::BridgeSetOnCallback(BridgeOnHandler handler, void* ctx)
     _ctx = ctx;
 }
 
+void IBridgeMaster::BridgeSetOnBinaryCallback(BridgeOnBinaryHandler handler, void* ctx)
+{
+    assert(handler);
+
+    if (_is_closed)
+    {
+        return;
+    }
+
+    _binary_handler = handler;
+    _binary_ctx = ctx;
+}
+
 void IBridgeMaster::BridgeRemoveOnCallback()
 {
     _handler = std::nullopt;
     _ctx = std::nullopt;
+    _binary_handler = std::nullopt;
+    _binary_ctx = std::nullopt;
 }
 
 void IBridgeMaster::_HandleOn(std::string& req, MessageTransPort::Handler handler)
@@ -477,6 +990,26 @@ void IBridgeMaster::_HandleOn(std::string& req, MessageTransPort::Handler handle
     }
 }
 
+void IBridgeMaster::_HandleOnBinary(std::vector<uint8_t>& req,
+                                    MessageTransPort::BinaryHandler handler)
+{
+    if (_is_closed)
+    {
+        return;
+    }
+
+    if (_binary_ctx.has_value() && _binary_handler.has_value())
+    {
+        _binary_handler.value()(req.data(), req.size(), _binary_ctx.value(),
+                                new BinaryContext(handler), bridge_master_binary_handler_callback);
+    }
+    else
+    {
+        auto res = to_bytes("runtime not load!");
+        handler(res, true);
+    }
+}
+
 void IBridgeMaster::IClose()
 {
     if (_router_master.has_value())
@@ -502,3 +1035,16 @@ void bridge_master_handler_callback(void* ctx, Result ret)
     ictx->handler(res, ret.failure != nullptr);
     delete ictx;
 }
+
+void bridge_master_binary_handler_callback(void* ctx,
+                                           const uint8_t* res,
+                                           size_t size,
+                                           bool is_err)
+{
+    assert(ctx);
+
+    IBridgeMaster::BinaryContext* ictx = (IBridgeMaster::BinaryContext*)ctx;
+    std::vector<uint8_t> bytes(res, res + size);
+    ictx->handler(bytes, is_err);
+    delete ictx;
+}
@@ -9,28 +9,43 @@
 #define LIBWEBVIEW_BRIDGE_H
 #pragma once
 
+#include <atomic>
 #include <functional>
-#include <map>
 #include <memory>
-#include <mutex>
 #include <optional>
+#include <vector>
 
 #include "include/cef_app.h"
 #include "message_router.h"
+#include "pending_calls.h"
+#include "shared_message.h"
 #include "webview.h"
 
 /* =================== MessageTransPort ====================== */
 
 void bridge_master_handler_callback(void* ctx, Result ret);
+void bridge_master_binary_handler_callback(void* ctx,
+                                           const uint8_t* res,
+                                           size_t size,
+                                           bool is_err);
 
-class MessageTransPort
+//
+// Calls wait in a PendingCalls table until the response arrives. A delayed
+// task on the thread that receives the messages expires the calls that are
+// past their deadline, it only runs while calls are pending.
+//
+class MessageTransPort : public std::enable_shared_from_this<MessageTransPort>
 {
 public:
     std::string CLOSED_ERR = std::string("is closed!");
     std::string NOT_HANDLER_ERR = std::string("not set handler!");
+    std::string TIMEOUT_ERR = std::string("timeout!");
 
     typedef std::function<void(std::string&, bool)> Handler;
     typedef std::function<void(std::string&, Handler)> OnHandler;
+    // binary payloads travel as CefBinaryValue, an error is its UTF-8 message.
+    typedef std::function<void(std::vector<uint8_t>&, bool)> BinaryHandler;
+    typedef std::function<void(std::vector<uint8_t>&, BinaryHandler)> OnBinaryHandler;
 
     MessageTransPort(bool is_master) : _is_master(is_master)
     {
@@ -46,26 +61,43 @@ public:
         _browser = browser;
     }
 
-    void Call(const std::string& req, Handler handler);
+    void Call(const std::string& req,
+              Handler handler,
+              uint32_t timeout_ms = PENDING_CALLS_TIMEOUT_MS);
+    void CallBinary(const void* req,
+                    size_t size,
+                    BinaryHandler handler,
+                    uint32_t timeout_ms = PENDING_CALLS_TIMEOUT_MS);
     void On(OnHandler handler);
+    void OnBinary(OnBinaryHandler handler);
 
     bool OnMessage(CefRefPtr<CefProcessMessage> msg);
     void IClose();
 
 private:
-    void _HandleCallRequest(CefRefPtr<CefListValue> args, int seq_id);
-    void _HandleCallResponse(CefRefPtr<CefListValue> args, int seq_id);
+    static void _OnExpire(std::weak_ptr<MessageTransPort> weak);
+    void _AddPendingCall(PendingCall call);
+    void _ScheduleExpire();
+    void _Expire();
+    void _FailCall(PendingCall& call, std::string& err);
+    void _SendMessage(CefRefPtr<CefProcessMessage> msg);
+    void _HandleCallRequest(std::string& req, int seq_id);
+    void _HandleCallResponse(std::string& res, bool is_err, int seq_id);
     void _OnHandleCallback(std::string& res, bool is_err, int seq_id);
+    void _HandleBinaryCallRequest(std::vector<uint8_t>& req, int seq_id);
+    void _HandleBinaryCallResponse(std::vector<uint8_t>& res, bool is_err, int seq_id);
+    void _OnHandleBinaryCallback(std::vector<uint8_t>& res, bool is_err, int seq_id);
     int _GetSeqNumber();
 
     std::optional<CefRefPtr<CefBrowser>> _browser = std::nullopt;
     std::optional<OnHandler> _on_handler = std::nullopt;
+    std::optional<OnBinaryHandler> _on_binary_handler = std::nullopt;
 
-    std::mutex _mutex;
-    std::map<int, Handler> _call_table;
-    bool _is_closed = false;
+    PendingCalls _pending_calls;
+    std::atomic<bool> _is_expire_scheduled = false;
+    std::atomic<bool> _is_closed = false;
     bool _is_master = false;
-    int _seq = 0;
+    std::atomic<uint32_t> _seq = 0;
 };
 
 /* =================== BridgeCallbacker ====================== */
@@ -197,6 +229,149 @@ private:
     IMPLEMENT_REFCOUNTING(BridgeCallProcesser);
 };
 
+/* =================== BridgeBuffer ====================== */
+
+//
+// The memory behind the ArrayBuffers the bridge hands to javascript. CEF 116
+// can not read the bytes of an ArrayBuffer created by javascript, so binary
+// requests have to be written into a buffer from |native.bridge.alloc| or one
+// received from the bridge, which the bridge can find again through its
+// release callback.
+//
+class BridgeBuffer : public CefV8ArrayBufferReleaseCallback
+{
+public:
+    BridgeBuffer(std::vector<uint8_t> data) : _data(std::move(data))
+    {
+    }
+
+    static CefRefPtr<CefV8Value> Create(std::vector<uint8_t> data);
+
+    //
+    // The buffer behind |value|, nullptr if it is not an ArrayBuffer of the
+    // bridge.
+    //
+    static BridgeBuffer* From(CefRefPtr<CefV8Value> value);
+
+    const std::vector<uint8_t>& Data()
+    {
+        return _data;
+    }
+
+    /* CefV8ArrayBufferReleaseCallback */
+
+    void ReleaseBuffer(void* buffer) override
+    {
+        _data = std::vector<uint8_t>();
+    }
+
+private:
+    std::vector<uint8_t> _data;
+
+    IMPLEMENT_REFCOUNTING(BridgeBuffer);
+};
+
+/* =================== BridgeAllocProcesser ====================== */
+
+// largest buffer a page can get from native.bridge.alloc, 64 MiB. the size
+// comes straight from script, a larger one throws instead of allocating.
+#define BRIDGE_ALLOC_MAX_SIZE (64 * 1024 * 1024)
+
+class BridgeAllocProcesser : public CefV8Handler
+{
+public:
+    /* CefV8Handler */
+
+    bool Execute(const CefString& name,
+                 CefRefPtr<CefV8Value> object,
+                 const CefV8ValueList& arguments,
+                 CefRefPtr<CefV8Value>& retval,
+                 CefString& exception);
+
+private:
+    IMPLEMENT_REFCOUNTING(BridgeAllocProcesser);
+};
+
+/* =================== BridgeBinaryCallbacker ====================== */
+
+class BridgeBinaryCallbacker : public CefV8Handler
+{
+public:
+    BridgeBinaryCallbacker(MessageTransPort::BinaryHandler handler) : _handler(handler)
+    {
+    }
+
+    /* CefV8Handler */
+
+    bool Execute(const CefString& name_,
+                 CefRefPtr<CefV8Value> object,
+                 const CefV8ValueList& arguments,
+                 CefRefPtr<CefV8Value>& retval,
+                 CefString& exception);
+
+private:
+    MessageTransPort::BinaryHandler _handler;
+
+    IMPLEMENT_REFCOUNTING(BridgeBinaryCallbacker);
+};
+
+/* =================== BridgeOnBinaryProcesser ====================== */
+
+class BridgeOnBinaryProcesser : public CefV8Handler
+{
+public:
+    BridgeOnBinaryProcesser(std::shared_ptr<MessageTransPort> transport) : _transport(transport)
+    {
+    }
+
+    /* CefV8Handler */
+
+    bool Execute(const CefString& name_,
+                 CefRefPtr<CefV8Value> object,
+                 const CefV8ValueList& arguments,
+                 CefRefPtr<CefV8Value>& retval,
+                 CefString& exception);
+
+private:
+    void _HandleOnCallback(CefRefPtr<CefV8Context> context,
+                           CefRefPtr<CefV8Value> callback,
+                           std::vector<uint8_t>& req,
+                           MessageTransPort::BinaryHandler handler);
+
+    std::shared_ptr<MessageTransPort> _transport;
+
+    IMPLEMENT_REFCOUNTING(BridgeOnBinaryProcesser);
+};
+
+/* =================== BridgeCallBinaryProcesser ====================== */
+
+class BridgeCallBinaryProcesser : public CefV8Handler
+{
+public:
+    BridgeCallBinaryProcesser(std::shared_ptr<MessageTransPort> transport)
+        : _transport(transport)
+    {
+    }
+
+    /* CefV8Handler */
+
+    bool Execute(const CefString& name,
+                 CefRefPtr<CefV8Value> object,
+                 const CefV8ValueList& arguments,
+                 CefRefPtr<CefV8Value>& retval,
+                 CefString& exception);
+
+private:
+    void _HandleCallback(CefRefPtr<CefV8Value> callback,
+                         CefRefPtr<CefV8Context> context,
+                         std::vector<uint8_t>& res,
+                         bool is_err);
+
+    std::shared_ptr<MessageTransPort> _transport;
+
+    IMPLEMENT_REFCOUNTING(BridgeCallBinaryProcesser);
+};
+
 /* =================== IBridgeHost ====================== */
 
 class IBridgeHost : public CefRenderProcessHandler
@@ -223,6 +398,10 @@ private:
     std::shared_ptr<MessageRouterHost> _router_host = std::make_shared<MessageRouterHost>();
     CefRefPtr<BridgeCallProcesser> _bridge_call = new BridgeCallProcesser(_transport);
     CefRefPtr<BridgeOnProcesser> _bridge_on = new BridgeOnProcesser(_transport);
+    CefRefPtr<BridgeCallBinaryProcesser> _bridge_call_binary =
+        new BridgeCallBinaryProcesser(_transport);
+    CefRefPtr<BridgeOnBinaryProcesser> _bridge_on_binary = new BridgeOnBinaryProcesser(_transport);
+    CefRefPtr<BridgeAllocProcesser> _bridge_alloc = new BridgeAllocProcesser();
     CefRefPtr<IpcSendProcesser> _ipc_send = new IpcSendProcesser(_router_host);
     CefRefPtr<IpcOnProcesser> _ipc_on = new IpcOnProcesser(_router_host);
 };
@@ -242,6 +421,16 @@ public:
         MessageTransPort::Handler handler;
     };
 
+    class BinaryContext
+    {
+    public:
+        BinaryContext(MessageTransPort::BinaryHandler handler_) : handler(handler_)
+        {
+        }
+
+        MessageTransPort::BinaryHandler handler;
+    };
+
     IBridgeMaster(std::shared_ptr<MessageRouter> router) : _router(router)
     {
     }
@@ -254,18 +443,26 @@ public:
     void SetBrowser(CefRefPtr<CefBrowser> browser);
     void BridgeMasterOnMessage(CefRefPtr<CefProcessMessage> message);
     void BridgeCall(char* req, BridgeCallCallback callback, void* ctx);
+    void BridgeCallBinary(const uint8_t* req,
+                          size_t size,
+                          BridgeBinaryCallCallback callback,
+                          void* ctx);
 
     void BridgeSetOnCallback(BridgeOnHandler handler, void* ctx);
+    void BridgeSetOnBinaryCallback(BridgeOnBinaryHandler handler, void* ctx);
     void BridgeRemoveOnCallback();
     void IClose();
 
 private:
     void _HandleOn(std::string& req, MessageTransPort::Handler handler);
+    void _HandleOnBinary(std::vector<uint8_t>& req, MessageTransPort::BinaryHandler handler);
 
     std::optional<std::shared_ptr<MessageRouterMaster>> _router_master = std::nullopt;
     std::optional<CefRefPtr<CefBrowser>> _browser = std::nullopt;
     std::optional<BridgeOnHandler> _handler = std::nullopt;
     std::optional<void*> _ctx = std::nullopt;
+    std::optional<BridgeOnBinaryHandler> _binary_handler = std::nullopt;
+    std::optional<void*> _binary_ctx = std::nullopt;
 
     std::shared_ptr<MessageRouter> _router;
     std::shared_ptr<MessageTransPort> _transport = std::make_shared<MessageTransPort>(true);
@@ -19,11 +19,22 @@ IBrowser::IBrowser(std::shared_ptr<MessageRouter> router,
     : _settings(settings)
     , _observer(observer)
     , _ctx(ctx)
+    , IControl(settings)
     , IBridgeMaster(router)
     , IRender(settings, observer, ctx)
     , IDisplay(settings, observer, ctx)
 {
     assert(settings);
+
+    if (observer.on_bridge)
+    {
+        BridgeSetOnCallback(observer.on_bridge, ctx);
+    }
+
+    if (observer.on_bridge_binary)
+    {
+        BridgeSetOnBinaryCallback(observer.on_bridge_binary, ctx);
+    }
 }
 
 CefRefPtr<CefDragHandler> IBrowser::GetDragHandler()
@@ -232,6 +243,21 @@ const void* IBrowser::GetHWND()
     return _browser.has_value() ? _browser.value()->GetHost()->GetWindowHandle() : nullptr;
 }
 
+void IBrowser::OnInput(const InputEvent& event)
+{
+    IRender::NotifyInput(event);
+}
+
+void IBrowser::OnInputText(InputTextType type, const std::string& text, int x, int y)
+{
+    IRender::NotifyInputText(type, text, x, y);
+}
+
+uint32_t IBrowser::GetInputInterval()
+{
+    return _settings->coalesce_input ? IRender::GetFrameInterval() : 0;
+}
+
 bool IBrowser::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
                                         CefRefPtr<CefFrame> frame,
                                         CefProcessId source_process,
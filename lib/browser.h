@@ -107,6 +107,15 @@ public:
     void IClose();
     void SetDevToolsOpenState(bool is_open);
     const void* GetHWND();
+protected:
+    /* IControl */
+
+    virtual void OnInput(const InputEvent& event) override;
+    virtual uint32_t GetInputInterval() override;
+
+    /* IMEControl */
+
+    virtual void OnInputText(InputTextType type, const std::string& text, int x, int y) override;
 private:
     std::optional<CefRefPtr<CefBrowser>> _browser = std::nullopt;
 
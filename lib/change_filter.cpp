@@ -0,0 +1,102 @@
+//
+//  change_filter.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/20.
+//
+
+#include "change_filter.h"
+
+#include "simd.h"
+
+bool ChangeFilter::Filter(const void* buffer, int width, int height, std::vector<Rect>& rects)
+{
+    const uint8_t* src = (const uint8_t*)buffer;
+    _frames.fetch_add(1, std::memory_order_relaxed);
+
+    if (width != _width || height != _height)
+    {
+        FrameBufferResize(_shadow, (size_t)width * height * FRAME_PIXEL_SIZE);
+        memcpy(_shadow.data(), src, _shadow.size());
+        _width = width;
+        _height = height;
+
+        rects.clear();
+        rects.push_back({ 0, 0, width, height });
+        return true;
+    }
+
+    size_t size = rects.size();
+    rects.erase(std::remove_if(rects.begin(), rects.end(),
+                               [&](Rect& rect) { return !_TrimRect(src, width, rect); }),
+                rects.end());
+
+    _dropped_rects.fetch_add(size - rects.size(), std::memory_order_relaxed);
+    for (auto& rect : rects)
+    {
+        FrameCopyRect(_shadow.data(), src, width, height, rect);
+    }
+
+    if (rects.empty())
+    {
+        _dropped_frames.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+void ChangeFilter::GetStats(ChangeFilterStats* stats)
+{
+    stats->frames = _frames.load(std::memory_order_relaxed);
+    stats->dropped_frames = _dropped_frames.load(std::memory_order_relaxed);
+    stats->dropped_rects = _dropped_rects.load(std::memory_order_relaxed);
+}
+
+bool ChangeFilter::_TrimRect(const uint8_t* src, int width, Rect& rect)
+{
+    rect = RectIntersect(rect, Rect{ 0, 0, _width, _height });
+    if (RectIsEmpty(rect))
+    {
+        return false;
+    }
+
+    size_t stride = (size_t)width * FRAME_PIXEL_SIZE;
+    size_t row_size = (size_t)rect.width * FRAME_PIXEL_SIZE;
+    size_t offset = (size_t)rect.x * FRAME_PIXEL_SIZE;
+
+    // Scan from both ends and shrink the rect to the first and last changed
+    // rows, a rect where no row changed is dropped entirely.
+    int top = rect.y;
+    int bottom = rect.y + rect.height - 1;
+    while (top <= bottom)
+    {
+        size_t row = (size_t)top * stride + offset;
+        if (!SimdEqual(src + row, _shadow.data() + row, row_size))
+        {
+            break;
+        }
+
+        top++;
+    }
+
+    if (top > bottom)
+    {
+        return false;
+    }
+
+    while (bottom > top)
+    {
+        size_t row = (size_t)bottom * stride + offset;
+        if (!SimdEqual(src + row, _shadow.data() + row, row_size))
+        {
+            break;
+        }
+
+        bottom--;
+    }
+
+    rect.y = top;
+    rect.height = bottom - top + 1;
+    return true;
+}
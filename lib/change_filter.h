@@ -0,0 +1,46 @@
+//
+//  change_filter.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/20.
+//
+
+#ifndef LIBWEBVIEW_CHANGE_FILTER_H
+#define LIBWEBVIEW_CHANGE_FILTER_H
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "frame.h"
+#include "webview.h"
+
+//
+// Compares the dirty regions of every painted frame against the last frame
+// that was let through, rects whose pixels did not change are removed and a
+// frame without any changed pixel is dropped.
+//
+class ChangeFilter
+{
+public:
+    //
+    // Returns false if nothing in |rects| changed and the frame should be
+    // dropped, otherwise |rects| is trimmed to the rows that really changed.
+    // Only called on the CEF UI thread.
+    //
+    bool Filter(const void* buffer, int width, int height, std::vector<Rect>& rects);
+    void GetStats(ChangeFilterStats* stats);
+
+private:
+    bool _TrimRect(const uint8_t* src, int width, Rect& rect);
+
+    std::vector<uint8_t> _shadow;
+    int _width = 0;
+    int _height = 0;
+
+    std::atomic<uint64_t> _frames = 0;
+    std::atomic<uint64_t> _dropped_frames = 0;
+    std::atomic<uint64_t> _dropped_rects = 0;
+};
+
+#endif  // LIBWEBVIEW_CHANGE_FILTER_H
@@ -7,46 +7,11 @@
 
 #include "control.h"
 
-#ifdef WIN32
-#include "windows.h"
-#endif
-
-#define ENTER_CODE 28
-#define SPACE_CODE 57
-#define L_SHIFT_CODE 42
-#define R_SHIFT_CODE 54
-#define L_CTRL_CODE 29
-
-#define IS_ABC(x) (x >= 0x10 && x <= 0x37)
-#define IS_NUMBER(x) (x >= 2 && x <= 11)
-#define IS_ALLOW_CHAR_MODE(x) (x != L_SHIFT_CODE && x != R_SHIFT_CODE && x != L_CTRL_CODE)
+#include "include/base/cef_callback.h"
+#include "include/wrapper/cef_closure_task.h"
 
-static const std::map<int, std::pair<char, char>> SYMBOL_REFS = {
-    {2, {'1', '!'}},   {3, {'2', '@'}},  {4, {'3', '#'}},   {5, {'4', '$'}},  {6, {'5', '%'}},
-    {7, {'6', '^'}},   {8, {'7', '&'}},  {9, {'8', '*'}},   {10, {'9', '('}}, {11, {'0', ')'}},
-    {12, {'-', '_'}},  {13, {'=', '+'}}, {26, {'[', '{'}},  {27, {']', '}'}}, {39, {';', ':'}},
-    {40, {'\'', '"'}}, {41, {'`', '~'}}, {43, {'\\', '|'}}, {51, {',', '<'}}, {52, {'.', '>'}},
-    {53, {'/', '?'}} };
-
-static bool is_symbol_from_code(int scan_code)
-{
-    constexpr std::array<int, 11> codes = { 26, 27, 43, 39, 40, 51, 52, 53, 41, 12, 13 };
-    for (int code : codes)
-    {
-        if (code == scan_code)
-        {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-static std::optional<std::pair<char, char>> get_symbol_ref(int scan_code)
-{
-    auto iter = SYMBOL_REFS.find(scan_code);
-    return iter != SYMBOL_REFS.end() ? std::optional(iter->second) : std::nullopt;
-}
+#define ENTER_CODE 0x1C
+#define TAB_CODE 0x0F
 
 CefBrowserHost::MouseButtonType from_c(MouseButtons button)
 {
@@ -68,7 +33,7 @@ cef_key_event_type_t from_c(bool pressed)
 {
     if (pressed)
     {
-        return cef_key_event_type_t::KEYEVENT_KEYDOWN;
+        return cef_key_event_type_t::KEYEVENT_RAWKEYDOWN;
     }
     else
     {
@@ -114,6 +79,8 @@ void IMEControl::OnIMEComposition(std::string input)
         return;
     }
 
+    OnInputText(kInputTextCommit, input, 0, 0);
+
     _browser.value()->GetHost()->ImeCommitText(input, CefRange::InvalidRange(), 0);
 }
 
@@ -124,6 +91,8 @@ void IMEControl::OnIMESetComposition(std::string input, int x, int y)
         return;
     }
 
+    OnInputText(kInputTextComposition, input, x, y);
+
     CefCompositionUnderline line;
     line.style = CEF_CUS_DASH;
     line.range = CefRange(0, y);
@@ -140,63 +109,237 @@ void IMEControl::IClose()
 
 /* =================== IControl ================= */
 
+IControl::IControl(BrowserSettings* settings) : _layout(settings->keyboard_layout)
+{
+}
+
 void IControl::SetBrowser(CefRefPtr<CefBrowser> browser)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+
     _browser = browser;
     IMEControl::SetBrowser(browser);
+
+    // the lock keys may already be on, after this the state follows the keys
+    // sent to the browser.
+    _keyboard.Sync();
+}
+
+void IControl::SyncKeyboardState()
+{
+    _Push({ kInputCommandSyncKeyboard });
 }
 
 void IControl::OnMouseClick(MouseButtons button, bool pressed)
+{
+    _Push({ kInputCommandClick, { kInputMouseClick, 0, 0, button, pressed } });
+}
+
+void IControl::OnMouseClickWithPosition(MouseButtons button, int x, int y, bool pressed)
+{
+    _Push({ kInputCommandEvent, { kInputMouseClick, x, y, button, pressed } });
+}
+
+void IControl::OnMouseMove(int x, int y)
+{
+    _Push({ kInputCommandEvent, { kInputMouseMove, x, y, 0, 0 } });
+}
+
+void IControl::OnMouseWheel(int x, int y)
+{
+    _Push({ kInputCommandEvent, { kInputMouseWheel, x, y, 0, 0 } });
+}
+
+void IControl::OnKeyboard(int scan_code, bool pressed, Modifiers modifiers)
+{
+    _Push({ kInputCommandEvent, { kInputKeyboard, 0, 0, scan_code, pressed | (modifiers << 1) } });
+}
+
+void IControl::OnTouch(int id,
+                       int x,
+                       int y,
+                       cef_touch_event_type_t type,
+                       cef_pointer_type_t pointer_type)
+{
+    _Push({ kInputCommandEvent, { kInputTouch, x, y, id, type | (pointer_type << 8) } });
+}
+
+size_t IControl::OnInputBatch(const InputEvent* events, size_t count)
 {
     if (_is_closed)
     {
-        return;
+        return 0;
     }
 
-    if (!_browser.has_value())
+    // stops at the first event that does not fit, so that the caller can send
+    // the rest later without reordering them.
+    size_t queued = 0;
+    while (queued < count && _queue.Push({ kInputCommandEvent, events[queued] }))
+    {
+        queued++;
+    }
+
+    if (queued > 0)
+    {
+        _ScheduleDrain();
+    }
+
+    return queued;
+}
+
+void IControl::OnText(const char* text, size_t size)
+{
+    if (size == 0)
     {
         return;
     }
 
-    if (button == MouseButtons::kLeft)
+    _Push({ kInputCommandText, {}, std::string(text, size) });
+}
+
+bool IControl::OnIMEComposition(std::string input)
+{
+    return _Push({ kInputCommandImeCommit, {}, std::move(input) });
+}
+
+bool IControl::OnIMESetComposition(std::string input, int x, int y)
+{
+    return _Push({ kInputCommandImeComposition, { (InputEventType)0, x, y }, std::move(input) });
+}
+
+void IControl::GetInputStats(InputStats* stats, bool reset)
+{
+    _queue.GetStats(stats, reset);
+}
+
+bool IControl::_Push(InputCommand command)
+{
+    if (_is_closed)
     {
-        _mouse_event.modifiers = EVENTFLAG_LEFT_MOUSE_BUTTON;
+        return false;
     }
-    else if (button == MouseButtons::kMiddle)
+
+    if (!_queue.Push(std::move(command)))
     {
-        _mouse_event.modifiers = EVENTFLAG_MIDDLE_MOUSE_BUTTON;
+        return false;
     }
-    else if (button == MouseButtons::kRight)
+
+    _ScheduleDrain();
+    return true;
+}
+
+void IControl::_ScheduleDrain()
+{
+    if (_queue.Schedule())
     {
-        _mouse_event.modifiers = EVENTFLAG_RIGHT_MOUSE_BUTTON;
+        CefPostTask(TID_UI, base::BindOnce(&IControl::_DrainInput, CefRefPtr<IControl>(this)));
     }
+}
 
-    _browser.value()->GetHost()->SendMouseClickEvent(_mouse_event, from_c(button), !pressed, 1);
+void IControl::_DrainInput()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _queue.BeginDrain();
+
+    size_t count = 0;
+    InputCommand command;
+    while (count < INPUT_QUEUE_MAX_DRAIN && _queue.Pop(command))
+    {
+        count++;
+
+        // input that arrives before the browser is created or after it is
+        // closed has nowhere to go.
+        if (!_is_closed && _browser.has_value())
+        {
+            _Execute(command);
+        }
+    }
+
+    _queue.EndDrain(count);
+
+    // the rest goes out with the next task, unless a producer posted one.
+    if (count == INPUT_QUEUE_MAX_DRAIN)
+    {
+        _ScheduleDrain();
+    }
 }
 
-void IControl::OnMouseClickWithPosition(MouseButtons button, int x, int y, bool pressed)
+void IControl::_Execute(InputCommand& command)
 {
-    if (_is_closed)
+    InputEvent& event = command.event;
+    if (command.type == kInputCommandEvent
+        && (event.type == kInputMouseMove || event.type == kInputMouseWheel))
     {
+        if (_Coalesce(event))
+        {
+            return;
+        }
+
+        if (event.type == kInputMouseMove)
+        {
+            _SendMouseMove(event.x, event.y);
+        }
+        else
+        {
+            _SendMouseWheel(event.x, event.y);
+        }
+
         return;
     }
 
-    if (!_browser.has_value())
+    // a held back move or wheel happened before this input.
+    _FlushPending();
+
+    if (command.type == kInputCommandClick)
     {
-        return;
+        _SendMouseClick((MouseButtons)event.code, _mouse_event.x, _mouse_event.y, event.flags);
+    }
+    else if (command.type == kInputCommandText)
+    {
+        _SendText(command.text);
     }
+    else if (command.type == kInputCommandImeCommit)
+    {
+        IMEControl::OnIMEComposition(std::move(command.text));
+    }
+    else if (command.type == kInputCommandImeComposition)
+    {
+        IMEControl::OnIMESetComposition(std::move(command.text), event.x, event.y);
+    }
+    else if (command.type == kInputCommandSyncKeyboard)
+    {
+        _keyboard.Sync();
+    }
+    else if (event.type == kInputMouseClick)
+    {
+        _SendMouseClick((MouseButtons)event.code, event.x, event.y, event.flags);
+    }
+    else if (event.type == kInputKeyboard)
+    {
+        _SendKeyboard(event.code, event.flags & 1, (Modifiers)(event.flags >> 1));
+    }
+    else if (event.type == kInputTouch)
+    {
+        _SendTouch(event);
+    }
+}
+
+void IControl::_SendMouseClick(MouseButtons button, int x, int y, bool pressed)
+{
+    OnInput({ kInputMouseClick, x, y, button, pressed });
 
     if (button == MouseButtons::kLeft)
     {
-        _mouse_event.modifiers = EVENTFLAG_LEFT_MOUSE_BUTTON;
+        _mouse_event.modifiers = EVENTFLAG_LEFT_MOUSE_BUTTON | _keyboard.Flags();
     }
     else if (button == MouseButtons::kMiddle)
     {
-        _mouse_event.modifiers = EVENTFLAG_MIDDLE_MOUSE_BUTTON;
+        _mouse_event.modifiers = EVENTFLAG_MIDDLE_MOUSE_BUTTON | _keyboard.Flags();
     }
     else if (button == MouseButtons::kRight)
     {
-        _mouse_event.modifiers = EVENTFLAG_RIGHT_MOUSE_BUTTON;
+        _mouse_event.modifiers = EVENTFLAG_RIGHT_MOUSE_BUTTON | _keyboard.Flags();
     }
 
     _mouse_event.x = x;
@@ -204,147 +347,227 @@ void IControl::OnMouseClickWithPosition(MouseButtons button, int x, int y, bool
     _browser.value()->GetHost()->SendMouseClickEvent(_mouse_event, from_c(button), !pressed, 1);
 }
 
-void IControl::OnMouseMove(int x, int y)
+void IControl::_SendMouseMove(int x, int y)
 {
-    if (_is_closed)
-    {
-        return;
-    }
-
-    if (!_browser.has_value())
-    {
-        return;
-    }
+    OnInput({ kInputMouseMove, x, y, 0, 0 });
 
     _mouse_event.x = x;
     _mouse_event.y = y;
     _browser.value()->GetHost()->SendMouseMoveEvent(_mouse_event, false);
 }
 
-void IControl::OnMouseWheel(int x, int y)
+void IControl::_SendMouseWheel(int x, int y)
 {
-    if (_is_closed)
-    {
-        return;
-    }
+    OnInput({ kInputMouseWheel, x, y, 0, 0 });
 
-    if (!_browser.has_value())
+    _browser.value()->GetHost()->SendMouseWheelEvent(_mouse_event, x, y);
+}
+
+void IControl::_SendKeyboard(int scan_code, bool pressed, Modifiers modifiers)
+{
+    OnInput({ kInputKeyboard, 0, 0, scan_code, pressed | (modifiers << 1) });
+
+    uint32_t flags = _keyboard.OnKey(scan_code, pressed) | from_c(modifiers);
+    KeyTranslation key = TranslateKey(_layout, scan_code, flags, _keyboard.IsAltGraph());
+
+    CefKeyEvent event;
+    event.type = from_c(pressed);
+    event.windows_key_code = key.windows_key_code;
+    event.native_key_code = key.native_key_code;
+    event.character = key.character;
+    event.unmodified_character = key.unmodified_character;
+    event.modifiers = flags | key.flags;
+
+    _browser.value()->GetHost()->SendKeyEvent(event);
+    if (!pressed || key.character == 0)
     {
         return;
     }
 
-    _browser.value()->GetHost()->SendMouseWheelEvent(_mouse_event, x, y);
+    event.type = KEYEVENT_CHAR;
+#ifdef WIN32
+    // a WM_CHAR carries the character in place of the key code.
+    event.windows_key_code = key.character;
+#endif
+
+    _browser.value()->GetHost()->SendKeyEvent(event);
 }
 
-void IControl::OnKeyboard(int scan_code, bool pressed, Modifiers modifiers)
+void IControl::_SendTouch(const InputEvent& input)
 {
-    if (_is_closed)
+    OnInput(input);
+
+    CefTouchEvent event;
+
+    event.id = input.code;
+    event.x = input.x;
+    event.y = input.y;
+    event.type = (cef_touch_event_type_t)(input.flags & 0xFF);
+    event.pointer_type = (cef_pointer_type_t)(input.flags >> 8);
+
+    _browser.value()->GetHost()->SendTouchEvent(event);
+}
+
+void IControl::_SendText(const std::string& text)
+{
+    // a whole run of text is a single commit, however long it is. only the
+    // characters that act on the page as keys are typed one by one.
+    size_t start = 0;
+    for (size_t i = 0; i <= text.size(); i++)
     {
-        return;
+        char c = i < text.size() ? text[i] : '\0';
+        if (c != '\0' && c != '\r' && c != '\n' && c != '\t')
+        {
+            continue;
+        }
+
+        if (i > start)
+        {
+            IMEControl::OnIMEComposition(text.substr(start, i - start));
+        }
+
+        start = i + 1;
+        if (c == '\n' && i > 0 && text[i - 1] == '\r')
+        {
+            continue;
+        }
+
+        if (c == '\r' || c == '\n' || c == '\t')
+        {
+            int scan_code = c == '\t' ? TAB_CODE : ENTER_CODE;
+            _SendKeyboard(scan_code, true, Modifiers::kNone);
+            _SendKeyboard(scan_code, false, Modifiers::kNone);
+        }
     }
+}
 
-    if (!_browser.has_value())
+bool IControl::StartReplay(const char* path, bool is_realtime)
+{
+    if (_is_closed)
     {
-        return;
+        return false;
     }
 
-#ifdef WIN32
-    auto windows_key_code = MapVirtualKeyA(scan_code, MAPVK_VSC_TO_VK);
-    bool is_capslock_on = (GetKeyState(VK_CAPITAL) & 0x0001) != 0;
-#else
-    bool is_capslock_on = false;
-    if (_display)
+    // only one replay drives the browser at a time.
+    StopReplay();
+
+    auto replayer = std::make_unique<InputReplayer>();
+    if (!replayer->Open(path))
     {
-        XKeyboardState state;
-        XGetKeyboardControl(_display, &state);
-        is_capslock_on = state.led_mask & (1 << 1);
-        XCloseDisplay(_display);
+        return false;
     }
-#endif
 
-    bool is_az = IS_ABC(scan_code);                   // a-z
-    bool is_number = IS_NUMBER(scan_code);            // 0-9
-    bool is_symbol = is_symbol_from_code(scan_code);  // []\;',./`-=
+    replayer->Start(this, is_realtime);
 
-    CefKeyEvent event;
-    event.type = from_c(pressed);
-    event.native_key_code = scan_code;
-    event.modifiers = from_c(modifiers);
-#ifdef WIN32
-    event.windows_key_code = windows_key_code;
-#endif
+    std::lock_guard<std::mutex> lock(_replayer_mutex);
+    _replayer = std::move(replayer);
+    return true;
+}
 
-    _browser.value()->GetHost()->SendKeyEvent(event);
-    if (!pressed)
+void IControl::StopReplay()
+{
+    std::unique_ptr<InputReplayer> replayer;
     {
-        return;
+        std::lock_guard<std::mutex> lock(_replayer_mutex);
+        replayer = std::move(_replayer);
     }
 
-    // not allow to char mode
-    if (!IS_ALLOW_CHAR_MODE(scan_code))
+    replayer.reset();
+}
+
+bool IControl::IsReplaying()
+{
+    std::lock_guard<std::mutex> lock(_replayer_mutex);
+    return _replayer && _replayer->IsRunning();
+}
+
+bool IControl::_Coalesce(const InputEvent& event)
+{
+    uint32_t interval = GetInputInterval();
+    if (interval == 0)
     {
-        return;
+        return false;
     }
 
-    if (!is_capslock_on && is_az && scan_code != ENTER_CODE)
+    // the first event of an interval goes out right away, so coalescing never
+    // delays an isolated event.
+    if (!_is_coalescing)
     {
-    #ifdef WIN32
-        event.windows_key_code += 32;
-    #endif
+        _is_coalescing = true;
+        CefPostDelayedTask(TID_UI,
+                           base::BindOnce(&IControl::_FlushInput, CefRefPtr<IControl>(this)),
+                           interval);
+        return false;
     }
 
-    if (is_number && modifiers == Modifiers::kShift)
+    if (_pending.has_value() && _pending->type != event.type)
     {
-        event.windows_key_code = get_symbol_ref(scan_code).value().second;
+        _FlushPending();
     }
-    else if (is_symbol && modifiers == Modifiers::kShift)
+
+    if (_pending.has_value() && event.type == kInputMouseWheel)
     {
-        event.windows_key_code = get_symbol_ref(scan_code).value().second;
+        _pending->x += event.x;
+        _pending->y += event.y;
     }
-    else if (is_symbol)
+    else
     {
-        event.windows_key_code = get_symbol_ref(scan_code).value().first;
+        _pending = event;
     }
 
-    // allow to char model
-    if (is_az || is_number || is_symbol || scan_code == SPACE_CODE)
-    {
-        event.type = KEYEVENT_CHAR;
-        _browser.value()->GetHost()->SendKeyEvent(event);
-    }
+    return true;
 }
 
-void IControl::OnTouch(int id,
-                       int x,
-                       int y,
-                       cef_touch_event_type_t type,
-                       cef_pointer_type_t pointer_type)
+void IControl::_FlushInput()
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+
     if (_is_closed)
     {
         return;
     }
 
-    if (!_browser.has_value())
+    // an interval without held back events ends coalescing, the next event
+    // starts a new one.
+    if (!_pending.has_value())
     {
+        _is_coalescing = false;
         return;
     }
 
-    CefTouchEvent event;
+    _FlushPending();
+    CefPostDelayedTask(TID_UI,
+                       base::BindOnce(&IControl::_FlushInput, CefRefPtr<IControl>(this)),
+                       std::max<uint32_t>(GetInputInterval(), 1));
+}
 
-    event.id = id;
-    event.x = x;
-    event.y = y;
-    event.type = type;
-    event.pointer_type = pointer_type;
+void IControl::_FlushPending()
+{
+    if (!_pending.has_value())
+    {
+        return;
+    }
 
-    _browser.value()->GetHost()->SendTouchEvent(event);
+    InputEvent event = _pending.value();
+    _pending = std::nullopt;
+
+    if (event.type == kInputMouseMove)
+    {
+        _SendMouseMove(event.x, event.y);
+    }
+    else
+    {
+        _SendMouseWheel(event.x, event.y);
+    }
 }
 
 void IControl::IClose()
 {
-    IMEControl::IClose();
+    StopReplay();
+
+    std::lock_guard<std::mutex> lock(_mutex);
 
+    IMEControl::IClose();
     _is_closed = true;
     _browser = std::nullopt;
 }
@@ -3,15 +3,19 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <mutex>
 #include <optional>
+#include <vector>
 
 #include "include/cef_app.h"
+#include "input_event.h"
+#include "input_queue.h"
+#include "input_replayer.h"
+#include "key_map.h"
+#include "keyboard_state.h"
 #include "webview.h"
 
-#ifdef CEF_X11
-#include <X11/XKBlib.h>
-#endif
-
 class IMEControl
 {
 public:
@@ -25,19 +29,35 @@ public:
     void OnIMESetComposition(std::string input, int x, int y);
     void IClose();
 
+protected:
+    // called before every text or composition is forwarded to the browser.
+    virtual void OnInputText(InputTextType type, const std::string& text, int x, int y)
+    {
+    }
+
 private:
     std::optional<CefRefPtr<CefBrowser>> _browser = std::nullopt;
     bool is_closed = false;
 };
 
-class IControl : public IMEControl
+//
+// Reference counted through the browser it is part of, so the tasks it posts
+// to the UI thread keep the browser alive until they ran.
+//
+class IControl : public IMEControl, public CefBaseRefCounted
 {
 public:
+    IControl(BrowserSettings* settings);
     ~IControl()
     {
         IClose();
     }
 
+    //
+    // The input methods can be called from any thread at the same time, they
+    // only push the input into a lock free queue. A task on the UI thread
+    // sends the queued input to the browser in order.
+    //
     void SetBrowser(CefRefPtr<CefBrowser> browser);
     void OnKeyboard(int scan_code, bool pressed, Modifiers modifiers);
     void OnMouseClick(MouseButtons button, bool pressed);
@@ -45,16 +65,64 @@ public:
     void OnMouseMove(int x, int y);
     void OnMouseWheel(int x, int y);
     void OnTouch(int id, int x, int y, cef_touch_event_type_t type, cef_pointer_type_t pointer_type);
+    size_t OnInputBatch(const InputEvent* events, size_t count);
+    void OnText(const char* text, size_t size);
+    // queued as well, so that text keeps its place between the keys.
+    bool OnIMEComposition(std::string input);
+    bool OnIMESetComposition(std::string input, int x, int y);
+    void SyncKeyboardState();
+    void GetInputStats(InputStats* stats, bool reset);
+    bool StartReplay(const char* path, bool is_realtime);
+    void StopReplay();
+    bool IsReplaying();
     void IClose();
 
+protected:
+    // called before every input event is forwarded to the browser.
+    virtual void OnInput(const InputEvent& event)
+    {
+    }
+
+    // the interval in milliseconds over which mouse moves and wheels are
+    // coalesced, 0 sends every event.
+    virtual uint32_t GetInputInterval()
+    {
+        return 0;
+    }
+
 private:
-    std::optional<CefRefPtr<CefBrowser>> _browser = std::nullopt;
+    bool _Push(InputCommand command);
+    void _ScheduleDrain();
+    void _DrainInput();
+    void _Execute(InputCommand& command);
+    void _SendMouseClick(MouseButtons button, int x, int y, bool pressed);
+    void _SendMouseMove(int x, int y);
+    void _SendMouseWheel(int x, int y);
+    void _SendKeyboard(int scan_code, bool pressed, Modifiers modifiers);
+    void _SendTouch(const InputEvent& event);
+    void _SendText(const std::string& text);
+    bool _Coalesce(const InputEvent& event);
+    void _FlushInput();
+    void _FlushPending();
 
-#ifdef CEF_X11
-    Display* _display = XOpenDisplay(nullptr);
-#endif
+    InputQueue _queue;
+    // the state below is only touched on the UI thread, the lock is there for
+    // |IClose|, which can run on any thread.
+    std::mutex _mutex;
+    std::optional<CefRefPtr<CefBrowser>> _browser = std::nullopt;
+    KeyboardLayout _layout;
+    KeyboardState _keyboard;
     CefMouseEvent _mouse_event;
-    bool _is_closed = false;
+    // the move or wheel held back until the end of the interval, and whether
+    // an interval is running.
+    std::optional<InputEvent> _pending = std::nullopt;
+    bool _is_coalescing = false;
+    // started and stopped from any thread.
+    std::mutex _replayer_mutex;
+    std::unique_ptr<InputReplayer> _replayer = nullptr;
+    std::atomic<bool> _is_closed = false;
+
+    IMPLEMENT_REFCOUNTING(IControl);
 };
 
 #endif  // LIBWEBVIEW_CONTROL_H
@@ -0,0 +1,200 @@
+//
+//  frame.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/18.
+//
+
+#ifndef LIBWEBVIEW_FRAME_H
+#define LIBWEBVIEW_FRAME_H
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "webview.h"
+
+// All frames coming out of CEF are BGRA32 without row padding.
+#define FRAME_PIXEL_SIZE 4
+
+// What a frame is tagged with when it is painted, see |Frame|.
+typedef struct
+{
+    uint64_t sequence;
+    uint64_t timestamp;
+    uint64_t request_id;
+    uint64_t input_id;
+    uint64_t input_timestamp;
+} FrameStamp;
+
+static inline bool RectIsEmpty(const Rect& rect)
+{
+    return rect.width <= 0 || rect.height <= 0;
+}
+
+static inline Rect RectIntersect(const Rect& a, const Rect& b)
+{
+    int x = std::max(a.x, b.x);
+    int y = std::max(a.y, b.y);
+    int right = std::min(a.x + a.width, b.x + b.width);
+    int bottom = std::min(a.y + a.height, b.y + b.height);
+    return Rect{ x, y, std::max(right - x, 0), std::max(bottom - y, 0) };
+}
+
+static inline Rect RectUnion(const Rect& a, const Rect& b)
+{
+    if (RectIsEmpty(a))
+    {
+        return b;
+    }
+
+    if (RectIsEmpty(b))
+    {
+        return a;
+    }
+
+    int x = std::min(a.x, b.x);
+    int y = std::min(a.y, b.y);
+    int right = std::max(a.x + a.width, b.x + b.width);
+    int bottom = std::max(a.y + a.height, b.y + b.height);
+    return Rect{ x, y, right - x, bottom - y };
+}
+
+//
+// Append |rects| to |list|, collapsing the whole list into its bounding box
+// once it grows past |max_size| so that the damage of frames that were never
+// consumed can not grow without limit.
+//
+static inline void RectListMerge(std::vector<Rect>& list,
+                                 const Rect* rects,
+                                 size_t size,
+                                 size_t max_size = 32)
+{
+    list.insert(list.end(), rects, rects + size);
+    if (list.size() <= max_size)
+    {
+        return;
+    }
+
+    Rect bounds = { 0, 0, 0, 0 };
+    for (auto& rect : list)
+    {
+        bounds = RectUnion(bounds, rect);
+    }
+
+    list.clear();
+    list.push_back(bounds);
+}
+
+//
+// Size in bytes of a |width| x |height| frame in |format|, planar formats
+// round the chroma planes up for odd sizes.
+//
+static inline size_t FrameSize(PixelFormat format, int width, int height)
+{
+    size_t pixels = (size_t)width * height;
+    if (format == PixelFormat::kI420 || format == PixelFormat::kNV12)
+    {
+        return pixels + (size_t)((width + 1) / 2) * ((height + 1) / 2) * 2;
+    }
+
+    return pixels * FRAME_PIXEL_SIZE;
+}
+
+//
+// Resize a frame buffer. The capacity grows geometrically and is kept when the
+// frame shrinks, so a stream of different sizes, like an interactive resize,
+// reuses the buffer instead of reallocating it for every size.
+//
+static inline void FrameBufferResize(std::vector<uint8_t>& buffer, size_t size)
+{
+    if (size > buffer.capacity())
+    {
+        buffer.reserve(std::max(size, buffer.capacity() + buffer.capacity() / 2));
+    }
+
+    buffer.resize(size);
+}
+
+//
+// Grow |rect| to even coordinates, so that it covers whole 2x2 blocks of the
+// subsampled chroma planes.
+//
+static inline Rect RectAlignEven(const Rect& rect)
+{
+    int x = rect.x & ~1;
+    int y = rect.y & ~1;
+    return Rect{ x, y, ((rect.x + rect.width + 1) & ~1) - x, ((rect.y + rect.height + 1) & ~1) - y };
+}
+
+static inline void PlaneCopyRect(uint8_t* dst,
+                                 const uint8_t* src,
+                                 size_t stride,
+                                 size_t pixel_size,
+                                 const Rect& rect)
+{
+    size_t offset = (size_t)rect.y * stride + (size_t)rect.x * pixel_size;
+    size_t row_size = (size_t)rect.width * pixel_size;
+    if (row_size == stride)
+    {
+        memcpy(dst + offset, src + offset, row_size * rect.height);
+        return;
+    }
+
+    for (int i = 0; i < rect.height; i++)
+    {
+        memcpy(dst + offset, src + offset, row_size);
+        offset += stride;
+    }
+}
+
+//
+// Copy the pixels of |rect| from |src| into |dst|, both buffers are frames of
+// |width| x |height| in |format| without row padding. The rect is clipped to
+// the frame bounds.
+//
+static inline void FrameCopyRect(uint8_t* dst,
+                                 const uint8_t* src,
+                                 int width,
+                                 int height,
+                                 const Rect& rect,
+                                 PixelFormat format = PixelFormat::kBGRA)
+{
+    Rect clip = RectIntersect(rect, Rect{ 0, 0, width, height });
+    if (RectIsEmpty(clip))
+    {
+        return;
+    }
+
+    if (format != PixelFormat::kI420 && format != PixelFormat::kNV12)
+    {
+        PlaneCopyRect(dst, src, (size_t)width * FRAME_PIXEL_SIZE, FRAME_PIXEL_SIZE, clip);
+        return;
+    }
+
+    PlaneCopyRect(dst, src, width, 1, clip);
+
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = (height + 1) / 2;
+    Rect chroma = { clip.x / 2,
+                    clip.y / 2,
+                    (clip.x + clip.width + 1) / 2 - clip.x / 2,
+                    (clip.y + clip.height + 1) / 2 - clip.y / 2 };
+
+    size_t offset = (size_t)width * height;
+    if (format == PixelFormat::kNV12)
+    {
+        PlaneCopyRect(dst + offset, src + offset, (size_t)chroma_width * 2, 2, chroma);
+    }
+    else
+    {
+        size_t plane_size = (size_t)chroma_width * chroma_height;
+        PlaneCopyRect(dst + offset, src + offset, chroma_width, 1, chroma);
+        PlaneCopyRect(dst + offset + plane_size, src + offset + plane_size, chroma_width, 1, chroma);
+    }
+}
+
+#endif  // LIBWEBVIEW_FRAME_H
@@ -0,0 +1,107 @@
+//
+//  frame_converter.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/21.
+//
+
+#include "frame_converter.h"
+
+#include "simd.h"
+
+FrameConverter::FrameConverter(PixelFormat format, bool straight_alpha)
+    : _format(format), _straight_alpha(straight_alpha)
+{
+}
+
+bool FrameConverter::IsRequired(PixelFormat format, bool straight_alpha)
+{
+    if (format == PixelFormat::kBGRA)
+    {
+        return straight_alpha;
+    }
+
+    return true;
+}
+
+const uint8_t* FrameConverter::Convert(const void* buffer,
+                                       int width,
+                                       int height,
+                                       std::vector<Rect>& rects)
+{
+    const uint8_t* src = (const uint8_t*)buffer;
+    Rect full = { 0, 0, width, height };
+
+    if (width != _width || height != _height)
+    {
+        FrameBufferResize(_buffer, FrameSize(_format, width, height));
+        _width = width;
+        _height = height;
+
+        rects.clear();
+        rects.push_back(full);
+    }
+
+    bool is_yuv = _format == PixelFormat::kI420 || _format == PixelFormat::kNV12;
+    for (auto& rect : rects)
+    {
+        rect = RectIntersect(is_yuv ? RectAlignEven(rect) : rect, full);
+        if (!RectIsEmpty(rect))
+        {
+            _ConvertRect(src, rect);
+        }
+    }
+
+    return _buffer.data();
+}
+
+void FrameConverter::_ConvertRect(const uint8_t* src, const Rect& rect)
+{
+    size_t stride = (size_t)_width * FRAME_PIXEL_SIZE;
+    size_t offset = (size_t)rect.y * stride + (size_t)rect.x * FRAME_PIXEL_SIZE;
+
+    if (_format == PixelFormat::kBGRA || _format == PixelFormat::kRGBA)
+    {
+        uint8_t* dst = _buffer.data();
+        for (int i = 0; i < rect.height; i++)
+        {
+            if (_format == PixelFormat::kRGBA)
+            {
+                SimdSwapRB(src + offset, dst + offset, rect.width);
+            }
+            else
+            {
+                memcpy(dst + offset, src + offset, (size_t)rect.width * FRAME_PIXEL_SIZE);
+            }
+
+            if (_straight_alpha)
+            {
+                SimdUnpremultiply(dst + offset, rect.width);
+            }
+
+            offset += stride;
+        }
+
+        return;
+    }
+
+    // rect is aligned to even coordinates, so it starts on a chroma sample.
+    size_t chroma_width = (_width + 1) / 2;
+    size_t chroma_height = (_height + 1) / 2;
+    uint8_t* y = _buffer.data() + (size_t)rect.y * _width + rect.x;
+    uint8_t* chroma = _buffer.data() + (size_t)_width * _height;
+
+    if (_format == PixelFormat::kNV12)
+    {
+        uint8_t* uv = chroma + (size_t)(rect.y / 2) * chroma_width * 2 + rect.x;
+        SimdBgraToYuv(src + offset, stride, rect.width, rect.height, y, _width, uv, uv + 1,
+                      chroma_width * 2, 2);
+    }
+    else
+    {
+        uint8_t* u = chroma + (size_t)(rect.y / 2) * chroma_width + rect.x / 2;
+        uint8_t* v = u + chroma_width * chroma_height;
+        SimdBgraToYuv(src + offset, stride, rect.width, rect.height, y, _width, u, v,
+                      chroma_width, 1);
+    }
+}
@@ -0,0 +1,46 @@
+//
+//  frame_converter.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/21.
+//
+
+#ifndef LIBWEBVIEW_FRAME_CONVERTER_H
+#define LIBWEBVIEW_FRAME_CONVERTER_H
+#pragma once
+
+#include <vector>
+
+#include "frame.h"
+#include "webview.h"
+
+//
+// Converts the BGRA frames painted by chromium into the output format of the
+// browser. The converted frame is kept between paints, so only the dirty
+// regions are converted every time.
+//
+class FrameConverter
+{
+public:
+    FrameConverter(PixelFormat format, bool straight_alpha);
+
+    static bool IsRequired(PixelFormat format, bool straight_alpha);
+
+    //
+    // Convert the dirty regions of |buffer| and return the whole converted
+    // frame. For subsampled formats |rects| are grown to even coordinates.
+    // Only called on the CEF UI thread.
+    //
+    const uint8_t* Convert(const void* buffer, int width, int height, std::vector<Rect>& rects);
+
+private:
+    void _ConvertRect(const uint8_t* src, const Rect& rect);
+
+    PixelFormat _format;
+    bool _straight_alpha;
+    std::vector<uint8_t> _buffer;
+    int _width = 0;
+    int _height = 0;
+};
+
+#endif  // LIBWEBVIEW_FRAME_CONVERTER_H
@@ -0,0 +1,155 @@
+//
+//  frame_output.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/26.
+//
+
+#include "frame_output.h"
+
+#include "simd.h"
+
+int FrameOutputs::Add(const Rect& crop, int scale, OutputCallback callback, void* ctx)
+{
+    if (scale != 1 && scale != 2 && scale != 4)
+    {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto output = std::make_unique<Output>();
+    output->id = _next_id++;
+    output->crop = crop;
+    output->scale = scale;
+    output->callback = callback;
+    output->ctx = ctx;
+    _outputs.push_back(std::move(output));
+    return _outputs.back()->id;
+}
+
+void FrameOutputs::Remove(int id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto it = _outputs.begin(); it != _outputs.end(); it++)
+    {
+        if ((*it)->id == id)
+        {
+            _outputs.erase(it);
+            return;
+        }
+    }
+}
+
+void FrameOutputs::Process(const void* buffer,
+                           int width,
+                           int height,
+                           const std::vector<Rect>& rects,
+                           const FrameStamp& stamp)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& output : _outputs)
+    {
+        if (!_Update(*output, (const uint8_t*)buffer, width, height, rects))
+        {
+            continue;
+        }
+
+        Frame frame = {};
+        frame.buf = output->buffer.data();
+        frame.size = output->buffer.size();
+        frame.format = kBGRA;
+        frame.width = output->source.width / output->scale;
+        frame.height = output->source.height / output->scale;
+        frame.rects = output->rects.data();
+        frame.rects_size = output->rects.size();
+        frame.request_id = stamp.request_id;
+        frame.sequence = stamp.sequence;
+        frame.timestamp = stamp.timestamp;
+        frame.input_id = stamp.input_id;
+        frame.input_timestamp = stamp.input_timestamp;
+        output->callback(&frame, output->ctx);
+    }
+}
+
+bool FrameOutputs::_Update(Output& output,
+                           const uint8_t* src,
+                           int width,
+                           int height,
+                           const std::vector<Rect>& rects)
+{
+    Rect view = { 0, 0, width, height };
+    Rect source = RectIsEmpty(output.crop) ? view : RectIntersect(output.crop, view);
+    int scale = output.scale;
+    int out_width = source.width / scale;
+    int out_height = source.height / scale;
+    if (out_width == 0 || out_height == 0)
+    {
+        return false;
+    }
+
+    output.rects.clear();
+    if (output.source.x != source.x || output.source.y != source.y ||
+        output.source.width != source.width || output.source.height != source.height)
+    {
+        FrameBufferResize(output.buffer, (size_t)out_width * out_height * FRAME_PIXEL_SIZE);
+        output.source = source;
+        output.rects.push_back({ 0, 0, out_width, out_height });
+    }
+    else
+    {
+        // Map the dirty rects onto the blocks of the output, a block that is
+        // only partly dirty is recomputed as a whole.
+        for (auto& rect : rects)
+        {
+            Rect dirty = RectIntersect(rect, source);
+            if (RectIsEmpty(dirty))
+            {
+                continue;
+            }
+
+            int x = (dirty.x - source.x) / scale;
+            int y = (dirty.y - source.y) / scale;
+            int right = std::min((dirty.x - source.x + dirty.width + scale - 1) / scale, out_width);
+            int bottom =
+                std::min((dirty.y - source.y + dirty.height + scale - 1) / scale, out_height);
+            if (right > x && bottom > y)
+            {
+                Rect block = { x, y, right - x, bottom - y };
+                RectListMerge(output.rects, &block, 1);
+            }
+        }
+
+        if (output.rects.empty())
+        {
+            return false;
+        }
+    }
+
+    size_t src_stride = (size_t)width * FRAME_PIXEL_SIZE;
+    size_t dst_stride = (size_t)out_width * FRAME_PIXEL_SIZE;
+    for (auto& rect : output.rects)
+    {
+        const uint8_t* s = src + (size_t)(source.y + rect.y * scale) * src_stride +
+            (size_t)(source.x + rect.x * scale) * FRAME_PIXEL_SIZE;
+        uint8_t* d = output.buffer.data() + (size_t)rect.y * dst_stride +
+            (size_t)rect.x * FRAME_PIXEL_SIZE;
+
+        if (scale == 1)
+        {
+            for (int row = 0; row < rect.height; row++)
+            {
+                memcpy(d + row * dst_stride, s + row * src_stride,
+                       (size_t)rect.width * FRAME_PIXEL_SIZE);
+            }
+        }
+        else
+        {
+            SimdDownscale(s, src_stride, rect.width, rect.height, d, dst_stride, scale);
+        }
+    }
+
+    return true;
+}
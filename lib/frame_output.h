@@ -0,0 +1,70 @@
+//
+//  frame_output.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/26.
+//
+
+#ifndef LIBWEBVIEW_FRAME_OUTPUT_H
+#define LIBWEBVIEW_FRAME_OUTPUT_H
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "frame.h"
+#include "webview.h"
+
+//
+// Derived outputs of the painted frames, each one a crop of the view that is
+// optionally downscaled. Outputs keep their pixels between frames, a paint
+// only recomputes the output pixels whose source blocks intersect the dirty
+// rects.
+//
+class FrameOutputs
+{
+public:
+    //
+    // Both can be called from any thread, |Remove| waits for a running
+    // callback of the output to return.
+    //
+    int Add(const Rect& crop, int scale, OutputCallback callback, void* ctx);
+    void Remove(int id);
+
+    //
+    // Update every output from a BGRA frame and call the callbacks of the
+    // outputs that changed. Only called on the CEF UI thread.
+    //
+    void Process(const void* buffer,
+                 int width,
+                 int height,
+                 const std::vector<Rect>& rects,
+                 const FrameStamp& stamp);
+
+private:
+    typedef struct
+    {
+        int id;
+        Rect crop;
+        int scale;
+        OutputCallback callback;
+        void* ctx;
+        // the region of the view the pixels were computed from.
+        Rect source = { 0, 0, 0, 0 };
+        std::vector<uint8_t> buffer;
+        std::vector<Rect> rects;
+    } Output;
+
+    bool _Update(Output& output,
+                 const uint8_t* src,
+                 int width,
+                 int height,
+                 const std::vector<Rect>& rects);
+
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<Output>> _outputs;
+    int _next_id = 0;
+};
+
+#endif  // LIBWEBVIEW_FRAME_OUTPUT_H
@@ -0,0 +1,77 @@
+//
+//  frame_rate.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/25.
+//
+
+#include "frame_rate.h"
+
+#include <algorithm>
+
+FrameRateController::FrameRateController(uint32_t max_rate)
+    : _max_rate(std::max(max_rate, (uint32_t)FRAME_RATE_MIN))
+    , _rate(std::max(max_rate, (uint32_t)FRAME_RATE_MIN))
+{
+}
+
+void FrameRateController::SetMaxRate(uint32_t rate)
+{
+    rate = std::max(rate, (uint32_t)FRAME_RATE_MIN);
+    _max_rate.store(rate, std::memory_order_relaxed);
+    _rate.store(rate, std::memory_order_relaxed);
+}
+
+bool FrameRateController::OnInput()
+{
+    _inputs.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t max_rate = _max_rate.load(std::memory_order_relaxed);
+    return _rate.exchange(max_rate, std::memory_order_relaxed) != max_rate;
+}
+
+void FrameRateController::OnFrame(bool is_behind)
+{
+    _frames++;
+    if (is_behind)
+    {
+        _behind++;
+    }
+}
+
+uint32_t FrameRateController::Update()
+{
+    uint32_t max_rate = _max_rate.load(std::memory_order_relaxed);
+    uint32_t rate = _rate.load(std::memory_order_relaxed);
+    uint32_t budget = rate * FRAME_RATE_WINDOW_MS;
+    uint32_t frames = _frames * 1000;
+
+    if (_inputs.exchange(0, std::memory_order_relaxed) > 0)
+    {
+        rate = max_rate;
+    }
+    else if (_behind * 4 > _frames)
+    {
+        // more than a quarter of the frames were not consumed in time.
+        rate /= 2;
+    }
+    else if (frames * 2 >= budget)
+    {
+        rate *= 2;
+    }
+    else if (frames * 4 < budget)
+    {
+        rate /= 2;
+    }
+
+    rate = std::clamp(rate, (uint32_t)FRAME_RATE_MIN, max_rate);
+    _rate.store(rate, std::memory_order_relaxed);
+    _frames = 0;
+    _behind = 0;
+    return rate;
+}
+
+uint32_t FrameRateController::Rate()
+{
+    return _rate.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+//
+//  frame_rate.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/25.
+//
+
+#ifndef LIBWEBVIEW_FRAME_RATE_H
+#define LIBWEBVIEW_FRAME_RATE_H
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// length of the window the controller looks at before changing the rate.
+#define FRAME_RATE_WINDOW_MS 250
+#define FRAME_RATE_MIN 1
+
+//
+// Picks the windowless frame rate of a browser from what happened in the last
+// window: input jumps straight to the maximum rate, a page that uses most of
+// its frame budget gets the rate doubled, while a mostly static page or a
+// consumer that can not keep up gets it halved.
+//
+class FrameRateController
+{
+public:
+    FrameRateController(uint32_t max_rate);
+
+    //
+    // Both can be called from any thread. |OnInput| returns true if the rate
+    // was raised to the maximum and has to be applied right away.
+    //
+    void SetMaxRate(uint32_t rate);
+    bool OnInput();
+
+    //
+    // Count a delivered frame, |is_behind| is set when the consumer missed the
+    // previous frame or took longer than a frame interval to handle it.
+    // Only called on the CEF UI thread.
+    //
+    void OnFrame(bool is_behind);
+
+    //
+    // Close the current window and return the rate for the next one. Only
+    // called on the CEF UI thread, every FRAME_RATE_WINDOW_MS.
+    //
+    uint32_t Update();
+    uint32_t Rate();
+
+private:
+    std::atomic<uint32_t> _max_rate;
+    std::atomic<uint32_t> _rate;
+    std::atomic<uint32_t> _inputs = 0;
+    uint32_t _frames = 0;
+    uint32_t _behind = 0;
+};
+
+#endif  // LIBWEBVIEW_FRAME_RATE_H
@@ -0,0 +1,249 @@
+//
+//  frame_ring.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/24.
+//
+
+#include "frame_ring.h"
+
+#ifdef LINUX
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// slots start on page boundaries so readers can map a single slot.
+#define FRAME_RING_ALIGN 4096
+
+static size_t align_size(size_t size)
+{
+    return (size + FRAME_RING_ALIGN - 1) / FRAME_RING_ALIGN * FRAME_RING_ALIGN;
+}
+
+FrameRing::FrameRing(PixelFormat format, uint32_t slots, int width, int height)
+    : _format(format)
+    , _slots(std::max(slots, (uint32_t)2))
+{
+    _damage.resize(_slots);
+
+#ifdef LINUX
+    _fd = memfd_create("webview-frame-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    _event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (_fd < 0 || _event_fd < 0)
+    {
+        return;
+    }
+
+    _data_offset = align_size(sizeof(FrameRingHeader) + sizeof(FrameRingSlot) * _slots);
+    if (ftruncate(_fd, _data_offset) != 0)
+    {
+        return;
+    }
+
+    // a reader shrinking the memory would crash the writer with SIGBUS.
+    fcntl(_fd, F_ADD_SEALS, F_SEAL_SHRINK);
+
+    void* memory = mmap(nullptr, _data_offset, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        return;
+    }
+
+    _memory = (uint8_t*)memory;
+    _size = _data_offset;
+
+    FrameRingHeader* header = (FrameRingHeader*)_memory;
+    header->magic = FRAME_RING_MAGIC;
+    header->version = FRAME_RING_VERSION;
+    header->slots = _slots;
+    header->size = _size;
+
+    if (!_Grow(FrameSize(format, width, height)))
+    {
+        munmap(_memory, _size);
+        _memory = nullptr;
+    }
+#endif
+}
+
+FrameRing::~FrameRing()
+{
+#ifdef LINUX
+    if (_memory != nullptr)
+    {
+        munmap(_memory, _size);
+    }
+
+    if (_fd >= 0)
+    {
+        close(_fd);
+    }
+
+    if (_event_fd >= 0)
+    {
+        close(_event_fd);
+    }
+#endif
+}
+
+bool FrameRing::IsValid()
+{
+    return _memory != nullptr;
+}
+
+void FrameRing::Write(const void* buffer,
+                      int width,
+                      int height,
+                      const std::vector<Rect>& rects,
+                      const FrameStamp& stamp)
+{
+#ifdef LINUX
+    if (_memory == nullptr)
+    {
+        return;
+    }
+
+    size_t size = FrameSize(_format, width, height);
+    // growing moves and invalidates every slot, so grow geometrically to keep
+    // an interactive resize from doing it for every size.
+    if (size > _capacity && !_Grow(std::max(size, _capacity + _capacity / 2)))
+    {
+        return;
+    }
+
+    uint64_t sequence = _sequence + 1;
+    uint32_t index = sequence % _slots;
+    FrameRingSlot* slot = _Slot(index);
+    std::vector<Rect>& damage = _damage[index];
+    const uint8_t* src = (const uint8_t*)buffer;
+    Rect full = { 0, 0, width, height };
+
+    if (slot->width != width || slot->height != height)
+    {
+        damage.clear();
+        damage.push_back(full);
+    }
+
+    uint64_t lock = slot->lock;
+    __atomic_store_n(&slot->lock, lock + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    // The slot holds the frame from |slots| publishes ago, so besides the
+    // dirty rects of this paint the regions changed since then are copied.
+    uint8_t* dst = _memory + slot->offset;
+    for (auto& rect : damage)
+    {
+        FrameCopyRect(dst, src, width, height, rect, _format);
+    }
+
+    for (auto& rect : rects)
+    {
+        FrameCopyRect(dst, src, width, height, rect, _format);
+    }
+
+    damage.clear();
+    for (uint32_t i = 0; i < _slots; i++)
+    {
+        if (i != index)
+        {
+            RectListMerge(_damage[i], rects.data(), rects.size());
+        }
+    }
+
+    _rects.clear();
+    if (_width != width || _height != height)
+    {
+        _rects.push_back(full);
+    }
+    else
+    {
+        RectListMerge(_rects, rects.data(), rects.size(), FRAME_RING_MAX_RECTS);
+    }
+
+    _width = width;
+    _height = height;
+
+    slot->sequence = sequence;
+    slot->timestamp = stamp.timestamp;
+    slot->request_id = stamp.request_id;
+    slot->size = size;
+    slot->format = _format;
+    slot->width = width;
+    slot->height = height;
+    slot->rects_size = (uint32_t)_rects.size();
+    memcpy(slot->rects, _rects.data(), _rects.size() * sizeof(Rect));
+
+    __atomic_store_n(&slot->lock, lock + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&((FrameRingHeader*)_memory)->sequence, sequence, __ATOMIC_RELEASE);
+    _sequence = sequence;
+
+    // the counter only saturates if nobody reads it, which is fine to ignore.
+    uint64_t value = 1;
+    [[maybe_unused]] auto ret = write(_event_fd, &value, sizeof(value));
+#endif
+}
+
+bool FrameRing::GetInfo(FrameRingInfo* info)
+{
+    if (_memory == nullptr)
+    {
+        return false;
+    }
+
+    info->fd = _fd;
+    info->event_fd = _event_fd;
+    return true;
+}
+
+bool FrameRing::_Grow(size_t capacity)
+{
+#ifdef LINUX
+    capacity = align_size(capacity);
+    size_t size = _data_offset + capacity * _slots;
+    if (ftruncate(_fd, size) != 0)
+    {
+        return false;
+    }
+
+    void* memory = mremap(_memory, _size, size, MREMAP_MAYMOVE);
+    if (memory == MAP_FAILED)
+    {
+        return false;
+    }
+
+    _memory = (uint8_t*)memory;
+    _size = size;
+    _capacity = capacity;
+
+    // Every slot moves, so all of them are invalidated and written in full the
+    // next time around.
+    for (uint32_t i = 0; i < _slots; i++)
+    {
+        FrameRingSlot* slot = _Slot(i);
+        uint64_t lock = slot->lock;
+        __atomic_store_n(&slot->lock, lock + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        slot->sequence = 0;
+        slot->offset = _data_offset + capacity * i;
+        slot->size = 0;
+        slot->width = 0;
+        slot->height = 0;
+        slot->rects_size = 0;
+
+        __atomic_store_n(&slot->lock, lock + 2, __ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n(&((FrameRingHeader*)_memory)->size, (uint64_t)size, __ATOMIC_RELEASE);
+    return true;
+#else
+    return false;
+#endif
+}
+
+FrameRingSlot* FrameRing::_Slot(uint32_t index)
+{
+    return (FrameRingSlot*)(_memory + sizeof(FrameRingHeader)) + index;
+}
@@ -0,0 +1,64 @@
+//
+//  frame_ring.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/24.
+//
+
+#ifndef LIBWEBVIEW_FRAME_RING_H
+#define LIBWEBVIEW_FRAME_RING_H
+#pragma once
+
+#include <vector>
+
+#include "frame.h"
+#include "webview.h"
+
+//
+// Exports frames to other local processes through a memfd backed ring of
+// slots, readers map the memory and read the pixels in place. Every slot keeps
+// its pixels between frames, so only the regions that changed since the slot
+// was last written are copied. Only supported on linux, elsewhere the ring
+// is never valid.
+//
+class FrameRing
+{
+public:
+    FrameRing(PixelFormat format, uint32_t slots, int width, int height);
+    ~FrameRing();
+
+    bool IsValid();
+
+    //
+    // Copy the frame into the next slot, publish it and signal the eventfd.
+    // Only called on the CEF UI thread.
+    //
+    void Write(const void* buffer,
+               int width,
+               int height,
+               const std::vector<Rect>& rects,
+               const FrameStamp& stamp);
+    bool GetInfo(FrameRingInfo* info);
+
+private:
+    bool _Grow(size_t capacity);
+    FrameRingSlot* _Slot(uint32_t index);
+
+    PixelFormat _format;
+    uint32_t _slots;
+    int _fd = -1;
+    int _event_fd = -1;
+    uint8_t* _memory = nullptr;
+    size_t _size = 0;
+    // offset of the first pixels and the bytes of pixels per slot.
+    size_t _data_offset = 0;
+    size_t _capacity = 0;
+    uint64_t _sequence = 0;
+    int _width = 0;
+    int _height = 0;
+    // per slot, the regions changed since the slot was last written.
+    std::vector<std::vector<Rect>> _damage;
+    std::vector<Rect> _rects;
+};
+
+#endif  // LIBWEBVIEW_FRAME_RING_H
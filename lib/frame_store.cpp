@@ -0,0 +1,136 @@
+//
+//  frame_store.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/18.
+//
+
+#include "frame_store.h"
+
+FrameStore::FrameStore(PixelFormat format, int width, int height) : _format(format)
+{
+    for (auto& slot : _slots)
+    {
+        _Resize(slot, width, height);
+    }
+}
+
+bool FrameStore::Write(const void* buffer,
+                       int width,
+                       int height,
+                       const std::vector<Rect>& rects,
+                       const FrameStamp& stamp)
+{
+    Slot& back = _slots[_back];
+    const uint8_t* src = (const uint8_t*)buffer;
+    Rect full = { 0, 0, width, height };
+
+    if (back.width != width || back.height != height)
+    {
+        _Resize(back, width, height);
+    }
+
+    // The back buffer holds a frame that is up to two publishes old, so besides
+    // the dirty rects of this paint the regions changed since then are copied.
+    for (auto& rect : back.damage)
+    {
+        FrameCopyRect(back.buffer.data(), src, width, height, rect, _format);
+    }
+
+    for (auto& rect : rects)
+    {
+        FrameCopyRect(back.buffer.data(), src, width, height, rect, _format);
+    }
+
+    back.damage.clear();
+    back.rects.clear();
+    for (uint8_t i = 0; i < _slots.size(); i++)
+    {
+        if (i != _back)
+        {
+            RectListMerge(_slots[i].damage, rects.data(), rects.size());
+        }
+    }
+
+    // If the consumer never took the previous frame, its changes are carried
+    // over so the consumer sees everything that changed since its last frame.
+    // The peek is racy on purpose: losing it only reports a few extra rects.
+    // The oldest input it showed is carried over as well.
+    uint8_t middle = _middle.load(std::memory_order_acquire);
+    Slot& prev = _slots[middle & SLOT_MASK];
+    if (middle & SLOT_FRESH && prev.width == width && prev.height == height)
+    {
+        RectListMerge(back.rects, prev.rects.data(), prev.rects.size());
+    }
+
+    uint64_t input_id = stamp.input_id;
+    uint64_t input_timestamp = stamp.input_timestamp;
+    if (middle & SLOT_FRESH && prev.frame.input_id != 0)
+    {
+        input_id = prev.frame.input_id;
+        input_timestamp = prev.frame.input_timestamp;
+    }
+
+    if (back.frame.width != width || back.frame.height != height)
+    {
+        back.rects.push_back(full);
+    }
+    else
+    {
+        RectListMerge(back.rects, rects.data(), rects.size());
+    }
+
+    back.frame.buf = back.buffer.data();
+    back.frame.size = back.buffer.size();
+    back.frame.format = _format;
+    back.frame.width = width;
+    back.frame.height = height;
+    back.frame.rects = back.rects.data();
+    back.frame.rects_size = back.rects.size();
+    back.frame.request_id = stamp.request_id;
+    back.frame.sequence = stamp.sequence;
+    back.frame.timestamp = stamp.timestamp;
+    back.frame.input_id = input_id;
+    back.frame.input_timestamp = input_timestamp;
+
+    middle = _middle.exchange(_back | SLOT_FRESH, std::memory_order_acq_rel);
+    _back = middle & SLOT_MASK;
+    return !(middle & SLOT_FRESH);
+}
+
+const Frame* FrameStore::Acquire()
+{
+    if (_is_acquired.exchange(true, std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+
+    if (!(_middle.load(std::memory_order_relaxed) & SLOT_FRESH))
+    {
+        _is_acquired.store(false, std::memory_order_release);
+        return nullptr;
+    }
+
+    uint8_t middle = _middle.exchange(_front, std::memory_order_acq_rel);
+    _front = middle & SLOT_MASK;
+    return &_slots[_front].frame;
+}
+
+void FrameStore::Release(const Frame* frame)
+{
+    assert(frame == &_slots[_front].frame);
+
+    _is_acquired.store(false, std::memory_order_release);
+}
+
+void FrameStore::_Resize(Slot& slot, int width, int height)
+{
+    FrameBufferResize(slot.buffer, FrameSize(_format, width, height));
+    slot.damage.clear();
+    slot.damage.reserve(32);
+    slot.damage.push_back({ 0, 0, width, height });
+    slot.rects.clear();
+    slot.rects.reserve(32);
+    slot.width = width;
+    slot.height = height;
+}
@@ -0,0 +1,79 @@
+//
+//  frame_store.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/18.
+//
+
+#ifndef LIBWEBVIEW_FRAME_STORE_H
+#define LIBWEBVIEW_FRAME_STORE_H
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "frame.h"
+#include "webview.h"
+
+//
+// Triple buffered frame store, the CEF UI thread writes frames into the back
+// buffer and publishes them with an atomic swap, the host pulls the latest
+// complete frame from any thread. Neither side ever waits for the other one,
+// and no buffer is allocated per frame once the pool is warm.
+//
+class FrameStore
+{
+public:
+    FrameStore(PixelFormat format, int width, int height);
+
+    //
+    // Copy the dirty regions of |buffer| into the back buffer and publish it,
+    // |buffer| is a frame in the format the store was created with. Only called
+    // on the CEF UI thread. Returns false if the previously published frame was
+    // never acquired.
+    //
+    bool Write(const void* buffer,
+               int width,
+               int height,
+               const std::vector<Rect>& rects,
+               const FrameStamp& stamp);
+
+    //
+    // Take the latest published frame, returns null if there is no frame newer
+    // than the last acquired one or the previous frame was not released yet.
+    // The frame stays valid until it is released.
+    //
+    const Frame* Acquire();
+    void Release(const Frame* frame);
+
+private:
+    typedef struct
+    {
+        std::vector<uint8_t> buffer;
+        // regions of the slot that are older than the latest written frame.
+        std::vector<Rect> damage;
+        // regions changed since the last frame taken by the consumer.
+        std::vector<Rect> rects;
+        Frame frame = {};
+        int width = 0;
+        int height = 0;
+    } Slot;
+
+    void _Resize(Slot& slot, int width, int height);
+
+    static constexpr uint8_t SLOT_MASK = 0x03;
+    static constexpr uint8_t SLOT_FRESH = 0x04;
+
+    PixelFormat _format;
+    std::array<Slot, 3> _slots;
+    // index of the published slot, SLOT_FRESH is set until the consumer takes it.
+    std::atomic<uint8_t> _middle = 1;
+    // only touched by the producer.
+    uint8_t _back = 0;
+    // only touched by the consumer.
+    uint8_t _front = 2;
+    std::atomic<bool> _is_acquired = false;
+};
+
+#endif  // LIBWEBVIEW_FRAME_STORE_H
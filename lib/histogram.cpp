@@ -0,0 +1,106 @@
+//
+//  histogram.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/29.
+//
+
+#include "histogram.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static inline int highest_bit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+void Histogram::Record(uint64_t value)
+{
+    _buckets[_BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t min = _min.load(std::memory_order_relaxed);
+    while (value < min && !_min.compare_exchange_weak(min, value, std::memory_order_relaxed))
+    {
+    }
+
+    uint64_t max = _max.load(std::memory_order_relaxed);
+    while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void Histogram::Snapshot(HistogramStats* stats, bool reset)
+{
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t count = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        counts[i] = reset ? _buckets[i].exchange(0, std::memory_order_relaxed)
+                          : _buckets[i].load(std::memory_order_relaxed);
+        count += counts[i];
+    }
+
+    uint64_t sum = reset ? _sum.exchange(0, std::memory_order_relaxed)
+                         : _sum.load(std::memory_order_relaxed);
+    uint64_t min = reset ? _min.exchange(UINT64_MAX, std::memory_order_relaxed)
+                         : _min.load(std::memory_order_relaxed);
+    uint64_t max = reset ? _max.exchange(0, std::memory_order_relaxed)
+                         : _max.load(std::memory_order_relaxed);
+
+    *stats = {};
+    stats->count = count;
+    if (count == 0)
+    {
+        return;
+    }
+
+    stats->min = min == UINT64_MAX ? 0 : min;
+    stats->max = max;
+    stats->mean = sum / count;
+
+    // per mille ranks of the percentiles, filled in bucket order.
+    const uint64_t ranks[] = { 500, 900, 990, 999 };
+    uint64_t* values[] = { &stats->p50, &stats->p90, &stats->p99, &stats->p999 };
+
+    size_t next = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS && next < 4; i++)
+    {
+        seen += counts[i];
+        while (next < 4 && seen * 1000 >= ranks[next] * count)
+        {
+            // a bucket midpoint can lie outside of the values actually seen.
+            *values[next] = std::min(std::max(_BucketValue(i), stats->min), stats->max);
+            next++;
+        }
+    }
+}
+
+size_t Histogram::_BucketIndex(uint64_t value)
+{
+    int shift = value == 0 ? 0 : std::max(highest_bit(value) - HISTOGRAM_SUB_BITS, 0);
+    return ((size_t)shift << HISTOGRAM_SUB_BITS) + (size_t)(value >> shift);
+}
+
+uint64_t Histogram::_BucketValue(size_t index)
+{
+    if (index < 2 * HISTOGRAM_SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    int shift = (int)(index >> HISTOGRAM_SUB_BITS) - 1;
+    uint64_t lower = (uint64_t)(index - ((size_t)shift << HISTOGRAM_SUB_BITS)) << shift;
+    return lower + ((1ull << shift) >> 1);
+}
@@ -0,0 +1,48 @@
+//
+//  histogram.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/29.
+//
+
+#ifndef LIBWEBVIEW_HISTOGRAM_H
+#define LIBWEBVIEW_HISTOGRAM_H
+#pragma once
+
+#include <atomic>
+
+#include "webview.h"
+
+//
+// A lock free histogram of unsigned 64 bit values with HDR style buckets:
+// every power of two range is split into HISTOGRAM_SUB_BUCKETS linear buckets,
+// so a percentile is off by at most 1 / HISTOGRAM_SUB_BUCKETS of its value
+// whatever its magnitude. Recording is a few relaxed atomic operations and
+// can happen on any thread.
+//
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+class Histogram
+{
+public:
+    void Record(uint64_t value);
+
+    //
+    // Summarize the recorded values, with |reset| the histogram starts over.
+    // Values recorded during a reset land either in this or the next summary.
+    //
+    void Snapshot(HistogramStats* stats, bool reset);
+
+private:
+    static size_t _BucketIndex(uint64_t value);
+    static uint64_t _BucketValue(size_t index);
+
+    std::atomic<uint64_t> _buckets[HISTOGRAM_BUCKETS] = {};
+    std::atomic<uint64_t> _sum = 0;
+    std::atomic<uint64_t> _min = UINT64_MAX;
+    std::atomic<uint64_t> _max = 0;
+};
+
+#endif  // LIBWEBVIEW_HISTOGRAM_H
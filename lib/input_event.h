@@ -0,0 +1,49 @@
+//
+//  input_event.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/28.
+//
+
+#ifndef LIBWEBVIEW_INPUT_EVENT_H
+#define LIBWEBVIEW_INPUT_EVENT_H
+#pragma once
+
+#include <stdint.h>
+
+typedef enum
+{
+    kInputMouseClick = 1,
+    kInputMouseMove = 2,
+    kInputMouseWheel = 3,
+    kInputKeyboard = 4,
+    kInputTouch = 5,
+} InputEventType;
+
+//
+// An input event as it is sent with |browser_send_input_batch| and recorded
+// when it is forwarded to the browser. |code| and |flags| depend on the type:
+// the button and the pressed state for clicks, the scan code and pressed |
+// modifiers << 1 for keys, the touch id and type | pointer_type << 8 for
+// touches. Wheel events carry their deltas in |x| and |y|.
+//
+typedef struct
+{
+    InputEventType type;
+    int32_t x;
+    int32_t y;
+    int32_t code;
+    int32_t flags;
+} InputEvent;
+
+//
+// Text input, which does not fit an InputEvent: a commit of |text| or a
+// composition of |text| with the selection from |x| to |y|.
+//
+typedef enum
+{
+    kInputTextCommit = 1,
+    kInputTextComposition = 2,
+} InputTextType;
+
+#endif  // LIBWEBVIEW_INPUT_EVENT_H
@@ -0,0 +1,121 @@
+//
+//  input_queue.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/3.
+//
+
+#include "input_queue.h"
+
+#include <stdint.h>
+
+#include <chrono>
+
+static inline uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static inline uint64_t load_counter(std::atomic<uint64_t>& counter, bool reset)
+{
+    return reset ? counter.exchange(0, std::memory_order_relaxed)
+                 : counter.load(std::memory_order_relaxed);
+}
+
+InputQueue::InputQueue() : _cells(std::make_unique<Cell[]>(INPUT_QUEUE_CAPACITY))
+{
+    // a cell is free for the push at position |sequence| and holds a command
+    // for the pop at position |sequence - 1|.
+    for (size_t i = 0; i < INPUT_QUEUE_CAPACITY; i++)
+    {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool InputQueue::Push(InputCommand command)
+{
+    command.timestamp = now();
+
+    Cell* cell;
+    size_t pos = _tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        cell = &_cells[pos & (INPUT_QUEUE_CAPACITY - 1)];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // the cell still holds the command of the previous lap.
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            pos = _tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->command = std::move(command);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    _queued.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool InputQueue::Schedule()
+{
+    // acq_rel pairs with |BeginDrain|, the commands pushed before a producer
+    // found a drain scheduled are visible to that drain.
+    return !_is_scheduled.exchange(true, std::memory_order_acq_rel);
+}
+
+void InputQueue::BeginDrain()
+{
+    _is_scheduled.exchange(false, std::memory_order_acq_rel);
+}
+
+bool InputQueue::Pop(InputCommand& command)
+{
+    Cell& cell = _cells[_head & (INPUT_QUEUE_CAPACITY - 1)];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != _head + 1)
+    {
+        return false;
+    }
+
+    command = std::move(cell.command);
+    cell.sequence.store(_head + INPUT_QUEUE_CAPACITY, std::memory_order_release);
+    _head++;
+
+    uint64_t time = now();
+    if (time >= command.timestamp)
+    {
+        _queue_delay.Record(time - command.timestamp);
+    }
+
+    return true;
+}
+
+void InputQueue::EndDrain(size_t count)
+{
+    if (count > 0)
+    {
+        _drain_size.Record(count);
+    }
+}
+
+void InputQueue::GetStats(InputStats* stats, bool reset)
+{
+    stats->queued = load_counter(_queued, reset);
+    stats->dropped = load_counter(_dropped, reset);
+    _queue_delay.Snapshot(&stats->queue_delay, reset);
+    _drain_size.Snapshot(&stats->drain_size, reset);
+}
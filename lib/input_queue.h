@@ -0,0 +1,101 @@
+//
+//  input_queue.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/3.
+//
+
+#ifndef LIBWEBVIEW_INPUT_QUEUE_H
+#define LIBWEBVIEW_INPUT_QUEUE_H
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "histogram.h"
+#include "input_event.h"
+#include "webview.h"
+
+// inputs that can wait for the UI thread before new ones are dropped, a power
+// of two.
+#define INPUT_QUEUE_CAPACITY 4096
+// inputs sent by one drain before the rest is left to a new task, so that a
+// flood of input can not hold up painting.
+#define INPUT_QUEUE_MAX_DRAIN 512
+
+typedef enum
+{
+    kInputCommandEvent = 1,
+    // a click at the current mouse position.
+    kInputCommandClick = 2,
+    kInputCommandText = 3,
+    kInputCommandImeCommit = 4,
+    // the selection of the composition is in |event.x| and |event.y|.
+    kInputCommandImeComposition = 5,
+    kInputCommandSyncKeyboard = 6,
+} InputCommandType;
+
+typedef struct
+{
+    InputCommandType type;
+    InputEvent event;
+    std::string text;
+    // when the command was queued, monotonic clock in nanoseconds.
+    uint64_t timestamp;
+} InputCommand;
+
+//
+// A bounded lock free multi producer single consumer queue of input, after
+// Dmitry Vyukov's bounded queue. Any thread can push, a push is a CAS on the
+// tail and never waits for the consumer. The CEF UI thread pops the commands
+// in the order they were pushed. |Schedule| elects the producer that posts
+// the drain task, so a burst of input costs a single task.
+//
+class InputQueue
+{
+public:
+    InputQueue();
+
+    //
+    // Returns false and drops the command if the queue is full.
+    //
+    bool Push(InputCommand command);
+
+    //
+    // Returns true for the first call after |BeginDrain|, the caller then has
+    // to post a task that drains the queue.
+    //
+    bool Schedule();
+
+    //
+    // Only called on the consumer thread: |BeginDrain| at the start of a
+    // drain, |Pop| until it returns false or the drain gives up, then
+    // |EndDrain| with the number of commands popped.
+    //
+    void BeginDrain();
+    bool Pop(InputCommand& command);
+    void EndDrain(size_t count);
+
+    void GetStats(InputStats* stats, bool reset);
+
+private:
+    typedef struct
+    {
+        std::atomic<size_t> sequence;
+        InputCommand command;
+    } Cell;
+
+    std::unique_ptr<Cell[]> _cells;
+    // producers and the consumer on their own cache lines.
+    alignas(64) std::atomic<size_t> _tail = 0;
+    alignas(64) size_t _head = 0;
+    std::atomic<bool> _is_scheduled = false;
+
+    std::atomic<uint64_t> _queued = 0;
+    std::atomic<uint64_t> _dropped = 0;
+    Histogram _queue_delay;
+    Histogram _drain_size;
+};
+
+#endif  // LIBWEBVIEW_INPUT_QUEUE_H
@@ -0,0 +1,165 @@
+//
+//  input_replayer.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/2.
+//
+
+#include "input_replayer.h"
+
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include "control.h"
+
+InputReplayer::~InputReplayer()
+{
+    if (_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _is_stopped = true;
+        }
+
+        _cond.notify_one();
+        _thread.join();
+    }
+}
+
+bool InputReplayer::Open(const char* path)
+{
+    return _reader.Open(path);
+}
+
+void InputReplayer::Start(IControl* control, bool is_realtime)
+{
+    _control = control;
+    _is_realtime = is_realtime;
+    _is_running = true;
+    _thread = std::thread(&InputReplayer::_Run, this);
+}
+
+bool InputReplayer::IsRunning()
+{
+    return _is_running;
+}
+
+void InputReplayer::_Run()
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t first_timestamp = UINT64_MAX;
+
+    RecordHeader header;
+    std::vector<uint8_t> payload;
+    while (!_is_stopped && _reader.Next(header, &payload))
+    {
+        if (header.type != kRecordInput && header.type != kRecordText)
+        {
+            continue;
+        }
+
+        if (_is_realtime)
+        {
+            // the replay starts with the first input, not with the recording.
+            first_timestamp = std::min(first_timestamp, header.timestamp);
+            auto due = start + std::chrono::nanoseconds(header.timestamp - first_timestamp);
+            if (due > std::chrono::steady_clock::now())
+            {
+                _Flush();
+
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (_cond.wait_until(lock, due, [&] { return _is_stopped.load(); }))
+                {
+                    break;
+                }
+            }
+        }
+
+        if (header.type == kRecordInput)
+        {
+            RecordInput input;
+            if (payload.size() != sizeof(input))
+            {
+                continue;
+            }
+
+            memcpy(&input, payload.data(), sizeof(input));
+            _batch.push_back(
+                { (InputEventType)input.type, input.x, input.y, input.code, input.flags });
+            if (_batch.size() >= INPUT_REPLAYER_MAX_BATCH)
+            {
+                _Flush();
+            }
+        }
+        else
+        {
+            RecordText text;
+            if (payload.size() < sizeof(text))
+            {
+                continue;
+            }
+
+            memcpy(&text, payload.data(), sizeof(text));
+            if (payload.size() - sizeof(text) < text.size)
+            {
+                continue;
+            }
+
+            // text is not part of a batch, the events before it go first.
+            _Flush();
+
+            std::string input((const char*)payload.data() + sizeof(text), text.size);
+            while (!_is_stopped)
+            {
+                bool is_queued = text.type == kInputTextCommit
+                    ? _control->OnIMEComposition(input)
+                    : _control->OnIMESetComposition(input, text.x, text.y);
+                if (is_queued)
+                {
+                    break;
+                }
+
+                _Backoff();
+            }
+        }
+    }
+
+    if (!_is_stopped)
+    {
+        _Flush();
+    }
+
+    _is_running = false;
+}
+
+void InputReplayer::_Flush()
+{
+    if (_batch.empty())
+    {
+        return;
+    }
+
+    // the input queue is bounded, a replay as fast as possible waits for the UI
+    // thread to make room rather than losing events.
+    size_t sent = 0;
+    while (!_is_stopped)
+    {
+        sent += _control->OnInputBatch(_batch.data() + sent, _batch.size() - sent);
+        if (sent == _batch.size())
+        {
+            break;
+        }
+
+        _Backoff();
+    }
+
+    _batch.clear();
+}
+
+void InputReplayer::_Backoff()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait_for(lock, std::chrono::milliseconds(1), [&] { return _is_stopped.load(); });
+}
@@ -0,0 +1,62 @@
+//
+//  input_replayer.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/2.
+//
+
+#ifndef LIBWEBVIEW_INPUT_REPLAYER_H
+#define LIBWEBVIEW_INPUT_REPLAYER_H
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "recording.h"
+
+class IControl;
+
+// input events sent in one batch when they are due at the same time.
+#define INPUT_REPLAYER_MAX_BATCH 256
+
+//
+// Plays back the input and text records of a recording on its own thread, by
+// calling into the IControl the events were recorded from. Input events that
+// are due together go out as one batch, when the input queue is full the
+// replay waits for it instead of dropping events.
+//
+class InputReplayer
+{
+public:
+    ~InputReplayer();
+
+    bool Open(const char* path);
+
+    //
+    // With |is_realtime| the events are sent with the timing they were
+    // recorded with, otherwise as fast as possible.
+    //
+    void Start(IControl* control, bool is_realtime);
+    bool IsRunning();
+
+private:
+    void _Run();
+    void _Flush();
+    void _Backoff();
+
+    RecordReader _reader;
+    IControl* _control = nullptr;
+    bool _is_realtime = false;
+    std::thread _thread;
+    std::vector<InputEvent> _batch;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::atomic<bool> _is_stopped = false;
+    std::atomic<bool> _is_running = false;
+};
+
+#endif  // LIBWEBVIEW_INPUT_REPLAYER_H
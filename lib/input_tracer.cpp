@@ -0,0 +1,122 @@
+//
+//  input_tracer.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/3.
+//
+
+#include "input_tracer.h"
+
+#include "render_metrics.h"
+
+static inline bool rects_contain(const std::vector<Rect>& rects, int x, int y)
+{
+    for (auto& rect : rects)
+    {
+        if (x >= rect.x && y >= rect.y && x < rect.x + rect.width && y < rect.y + rect.height)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+InputTracer::InputTracer(float scale_factor) : _scale_factor(scale_factor)
+{
+}
+
+void InputTracer::OnInput(const InputEvent& event)
+{
+    // input is given in view coordinates, the dirty rects are in pixels.
+    bool has_position = event.type == kInputMouseClick
+        || event.type == kInputMouseMove
+        || event.type == kInputTouch;
+    _Push((int)(event.x * _scale_factor), (int)(event.y * _scale_factor), has_position);
+}
+
+void InputTracer::OnInputText()
+{
+    _Push(0, 0, false);
+}
+
+void InputTracer::_Push(int x, int y, bool has_position)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_pending.size() >= INPUT_TRACER_MAX_PENDING)
+    {
+        _pending.pop_front();
+        _expired.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // stamped under the lock, so the pending inputs stay in time order.
+    _pending.push_back(Trace{ ++_id, RenderMetrics::Now(), x, y, has_position });
+}
+
+void InputTracer::OnPaint(const std::vector<Rect>& rects, FrameStamp& stamp)
+{
+    uint64_t now = stamp.timestamp;
+    uint64_t timeout = (uint64_t)INPUT_TRACER_TIMEOUT_MS * 1000000;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < _pending.size(); i++)
+    {
+        Trace trace = _pending[i];
+
+        // sent after the paint arrived, it can not be in this one.
+        if (trace.timestamp > now)
+        {
+            _pending[kept++] = trace;
+            continue;
+        }
+
+        if (now - trace.timestamp > timeout)
+        {
+            _expired.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (trace.has_position && !rects_contain(rects, trace.x, trace.y))
+        {
+            _pending[kept++] = trace;
+            continue;
+        }
+
+        _input_to_paint.Record(now - trace.timestamp);
+        _painted.push_back(trace);
+    }
+
+    _pending.resize(kept);
+
+    if (!_painted.empty())
+    {
+        stamp.input_id = _painted.front().id;
+        stamp.input_timestamp = _painted.front().timestamp;
+    }
+}
+
+void InputTracer::OnDelivered()
+{
+    if (_painted.empty())
+    {
+        return;
+    }
+
+    uint64_t now = RenderMetrics::Now();
+    for (auto& trace : _painted)
+    {
+        _input_to_delivered.Record(now - trace.timestamp);
+    }
+
+    _painted.clear();
+}
+
+void InputTracer::GetStats(RenderStats* stats, bool reset)
+{
+    stats->expired_inputs = reset ? _expired.exchange(0, std::memory_order_relaxed)
+                                  : _expired.load(std::memory_order_relaxed);
+    _input_to_paint.Snapshot(&stats->input_to_paint, reset);
+    _input_to_delivered.Snapshot(&stats->input_to_delivered, reset);
+}
@@ -0,0 +1,80 @@
+//
+//  input_tracer.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/3.
+//
+
+#ifndef LIBWEBVIEW_INPUT_TRACER_H
+#define LIBWEBVIEW_INPUT_TRACER_H
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "frame.h"
+#include "histogram.h"
+#include "input_event.h"
+#include "webview.h"
+
+// inputs waiting for a paint before the oldest one is given up.
+#define INPUT_TRACER_MAX_PENDING 256
+// an input that no paint answered within this time did not change the view.
+#define INPUT_TRACER_TIMEOUT_MS 1000
+
+//
+// Follows input events to the frames that show them. Every input is stamped
+// with an id and the time it is forwarded to chromium. The first paint whose
+// dirty rects contain the position of a click, move or touch is attributed to
+// it, keys, wheels and text have no position and take the next paint. The
+// time to that paint and to the delivery of its frame to the host are
+// recorded. Inputs can be reported from any thread, the paint hooks run on
+// the CEF UI thread.
+//
+class InputTracer
+{
+public:
+    InputTracer(float scale_factor);
+
+    void OnInput(const InputEvent& event);
+    void OnInputText();
+
+    //
+    // Attribute the waiting inputs to the paint of |stamp|, the stamp is
+    // tagged with the oldest of them.
+    //
+    void OnPaint(const std::vector<Rect>& rects, FrameStamp& stamp);
+    void OnDelivered();
+
+    void GetStats(RenderStats* stats, bool reset);
+
+private:
+    typedef struct
+    {
+        uint64_t id;
+        uint64_t timestamp;
+        int x;
+        int y;
+        bool has_position;
+    } Trace;
+
+    void _Push(int x, int y, bool has_position);
+
+    float _scale_factor;
+
+    std::mutex _mutex;
+    std::deque<Trace> _pending;
+    uint64_t _id = 0;
+
+    // inputs attributed to the paint being delivered, only touched on the
+    // CEF UI thread.
+    std::vector<Trace> _painted;
+
+    std::atomic<uint64_t> _expired = 0;
+    Histogram _input_to_paint;
+    Histogram _input_to_delivered;
+};
+
+#endif  // LIBWEBVIEW_INPUT_TRACER_H
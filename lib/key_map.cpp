@@ -0,0 +1,392 @@
+//
+//  key_map.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/1.
+//
+
+#include "key_map.h"
+
+#include <array>
+
+#include "include/cef_app.h"
+
+// non extended codes live at their scan code, extended codes at 0x80 + code.
+#define KEY_MAP_SIZE 256
+#define KEY_EXTENDED 0x80
+
+#define VK_BACK 0x08
+#define VK_TAB 0x09
+#define VK_CLEAR 0x0C
+#define VK_RETURN 0x0D
+#define VK_SHIFT 0x10
+#define VK_CONTROL 0x11
+#define VK_MENU 0x12
+#define VK_CAPITAL 0x14
+#define VK_ESCAPE 0x1B
+#define VK_SPACE 0x20
+#define VK_PRIOR 0x21
+#define VK_NEXT 0x22
+#define VK_END 0x23
+#define VK_HOME 0x24
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN 0x28
+#define VK_SNAPSHOT 0x2C
+#define VK_INSERT 0x2D
+#define VK_DELETE 0x2E
+#define VK_LWIN 0x5B
+#define VK_RWIN 0x5C
+#define VK_APPS 0x5D
+#define VK_NUMPAD0 0x60
+#define VK_MULTIPLY 0x6A
+#define VK_ADD 0x6B
+#define VK_SUBTRACT 0x6D
+#define VK_DECIMAL 0x6E
+#define VK_DIVIDE 0x6F
+#define VK_F1 0x70
+#define VK_NUMLOCK 0x90
+#define VK_SCROLL 0x91
+#define VK_OEM_1 0xBA
+#define VK_OEM_PLUS 0xBB
+#define VK_OEM_COMMA 0xBC
+#define VK_OEM_MINUS 0xBD
+#define VK_OEM_PERIOD 0xBE
+#define VK_OEM_2 0xBF
+#define VK_OEM_3 0xC0
+#define VK_OEM_4 0xDB
+#define VK_OEM_5 0xDC
+#define VK_OEM_6 0xDD
+#define VK_OEM_7 0xDE
+#define VK_OEM_8 0xDF
+#define VK_OEM_102 0xE2
+
+typedef struct
+{
+    uint16_t key_code;
+    // the key code with num lock on, only set for the numpad keys that move
+    // the caret with num lock off.
+    uint16_t numpad_key_code;
+    // linux evdev code, the X keycode is 8 above it.
+    uint16_t evdev_code;
+    // the character typed without and with shift, and with AltGr.
+    char16_t chars[3];
+    // caps lock acts as shift for this key.
+    bool is_letter;
+    bool is_keypad;
+} KeyInfo;
+
+typedef std::array<KeyInfo, KEY_MAP_SIZE> KeyMap;
+
+static constexpr void set_key(KeyMap& map,
+                              int index,
+                              uint16_t key_code,
+                              char16_t normal = 0,
+                              char16_t shift = 0,
+                              char16_t altgr = 0)
+{
+    // evdev codes match the non extended set 1 codes.
+    KeyInfo& info = map[index];
+    info.key_code = key_code;
+    info.evdev_code = index < KEY_EXTENDED ? index : info.evdev_code;
+    info.chars[0] = normal;
+    info.chars[1] = shift;
+    info.chars[2] = altgr;
+    info.is_letter = false;
+}
+
+static constexpr void set_letter(KeyMap& map, int index, char letter)
+{
+    set_key(map, index, letter - 'a' + 'A', letter, letter - 'a' + 'A');
+    map[index].is_letter = true;
+}
+
+static constexpr void set_extended(KeyMap& map,
+                                   int code,
+                                   uint16_t key_code,
+                                   uint16_t evdev_code,
+                                   char16_t normal = 0)
+{
+    map[KEY_EXTENDED + code].evdev_code = evdev_code;
+    set_key(map, KEY_EXTENDED + code, key_code, normal, normal);
+}
+
+static constexpr void set_numpad(KeyMap& map, int code, uint16_t key_code, uint16_t numpad_key_code)
+{
+    char16_t normal = numpad_key_code == VK_DECIMAL ? u'.' : numpad_key_code - VK_NUMPAD0 + u'0';
+    set_key(map, code, key_code, normal, normal);
+    map[code].numpad_key_code = numpad_key_code;
+    map[code].is_keypad = true;
+}
+
+static constexpr KeyMap make_us_keys()
+{
+    KeyMap map = {};
+
+    set_key(map, 0x01, VK_ESCAPE, 0x1B, 0x1B);
+    const char16_t digits[] = u"1234567890";
+    const char16_t shifted[] = u"!@#$%^&*()";
+    for (int i = 0; i < 10; i++)
+    {
+        set_key(map, 0x02 + i, digits[i], digits[i], shifted[i]);
+    }
+
+    set_key(map, 0x0C, VK_OEM_MINUS, u'-', u'_');
+    set_key(map, 0x0D, VK_OEM_PLUS, u'=', u'+');
+    set_key(map, 0x0E, VK_BACK, 0x08, 0x08);
+    set_key(map, 0x0F, VK_TAB, u'\t', u'\t');
+
+    const char rows[][11] = { "qwertyuiop", "asdfghjkl", "zxcvbnm" };
+    const int starts[] = { 0x10, 0x1E, 0x2C };
+    for (int row = 0; row < 3; row++)
+    {
+        for (int i = 0; rows[row][i] != 0; i++)
+        {
+            set_letter(map, starts[row] + i, rows[row][i]);
+        }
+    }
+
+    set_key(map, 0x1A, VK_OEM_4, u'[', u'{');
+    set_key(map, 0x1B, VK_OEM_6, u']', u'}');
+    set_key(map, 0x1C, VK_RETURN, u'\r', u'\r');
+    set_key(map, 0x1D, VK_CONTROL);
+    set_key(map, 0x27, VK_OEM_1, u';', u':');
+    set_key(map, 0x28, VK_OEM_7, u'\'', u'"');
+    set_key(map, 0x29, VK_OEM_3, u'`', u'~');
+    set_key(map, 0x2A, VK_SHIFT);
+    set_key(map, 0x2B, VK_OEM_5, u'\\', u'|');
+    set_key(map, 0x33, VK_OEM_COMMA, u',', u'<');
+    set_key(map, 0x34, VK_OEM_PERIOD, u'.', u'>');
+    set_key(map, 0x35, VK_OEM_2, u'/', u'?');
+    set_key(map, 0x36, VK_SHIFT);
+    set_key(map, 0x37, VK_MULTIPLY, u'*', u'*');
+    set_key(map, 0x38, VK_MENU);
+    set_key(map, 0x39, VK_SPACE, u' ', u' ');
+    set_key(map, 0x3A, VK_CAPITAL);
+    for (int i = 0; i < 10; i++)
+    {
+        set_key(map, 0x3B + i, VK_F1 + i);
+    }
+
+    set_key(map, 0x45, VK_NUMLOCK);
+    set_key(map, 0x46, VK_SCROLL);
+    set_numpad(map, 0x47, VK_HOME, VK_NUMPAD0 + 7);
+    set_numpad(map, 0x48, VK_UP, VK_NUMPAD0 + 8);
+    set_numpad(map, 0x49, VK_PRIOR, VK_NUMPAD0 + 9);
+    set_key(map, 0x4A, VK_SUBTRACT, u'-', u'-');
+    set_numpad(map, 0x4B, VK_LEFT, VK_NUMPAD0 + 4);
+    set_numpad(map, 0x4C, VK_CLEAR, VK_NUMPAD0 + 5);
+    set_numpad(map, 0x4D, VK_RIGHT, VK_NUMPAD0 + 6);
+    set_key(map, 0x4E, VK_ADD, u'+', u'+');
+    set_numpad(map, 0x4F, VK_END, VK_NUMPAD0 + 1);
+    set_numpad(map, 0x50, VK_DOWN, VK_NUMPAD0 + 2);
+    set_numpad(map, 0x51, VK_NEXT, VK_NUMPAD0 + 3);
+    set_numpad(map, 0x52, VK_INSERT, VK_NUMPAD0);
+    set_numpad(map, 0x53, VK_DELETE, VK_DECIMAL);
+    map[0x37].is_keypad = true;
+    map[0x4A].is_keypad = true;
+    map[0x4E].is_keypad = true;
+
+    set_key(map, 0x56, VK_OEM_102, u'\\', u'|');
+    set_key(map, 0x57, VK_F1 + 10);
+    set_key(map, 0x58, VK_F1 + 11);
+
+    set_extended(map, 0x1C, VK_RETURN, 96, u'\r');
+    set_extended(map, 0x1D, VK_CONTROL, 97);
+    set_extended(map, 0x35, VK_DIVIDE, 98, u'/');
+    set_extended(map, 0x37, VK_SNAPSHOT, 99);
+    set_extended(map, 0x38, VK_MENU, 100);
+    set_extended(map, 0x47, VK_HOME, 102);
+    set_extended(map, 0x48, VK_UP, 103);
+    set_extended(map, 0x49, VK_PRIOR, 104);
+    set_extended(map, 0x4B, VK_LEFT, 105);
+    set_extended(map, 0x4D, VK_RIGHT, 106);
+    set_extended(map, 0x4F, VK_END, 107);
+    set_extended(map, 0x50, VK_DOWN, 108);
+    set_extended(map, 0x51, VK_NEXT, 109);
+    set_extended(map, 0x52, VK_INSERT, 110);
+    set_extended(map, 0x53, VK_DELETE, 111);
+    set_extended(map, 0x5B, VK_LWIN, 125);
+    set_extended(map, 0x5C, VK_RWIN, 126);
+    set_extended(map, 0x5D, VK_APPS, 127);
+    map[KEY_EXTENDED + 0x1C].is_keypad = true;
+    map[KEY_EXTENDED + 0x35].is_keypad = true;
+
+    return map;
+}
+
+//
+// The other layouts start from the US one, the virtual key codes follow the
+// windows layout of the same name. Dead keys do not type a character by
+// themselves.
+//
+
+static constexpr KeyMap make_uk_keys()
+{
+    KeyMap map = make_us_keys();
+
+    set_key(map, 0x03, u'2', u'2', u'"');
+    set_key(map, 0x04, u'3', u'3', u'\u00A3');
+    set_key(map, 0x05, u'4', u'4', u'$', u'\u20AC');
+    set_key(map, 0x28, VK_OEM_3, u'\'', u'@');
+    set_key(map, 0x29, VK_OEM_8, u'`', u'\u00AC', u'\u00A6');
+    set_key(map, 0x2B, VK_OEM_7, u'#', u'~');
+    set_key(map, 0x56, VK_OEM_5, u'\\', u'|');
+
+    return map;
+}
+
+static constexpr KeyMap make_de_keys()
+{
+    KeyMap map = make_us_keys();
+
+    const char16_t shifted[] = u"!\"\u00A7$%&/()=";
+    for (int i = 0; i < 10; i++)
+    {
+        map[0x02 + i].chars[1] = shifted[i];
+    }
+
+    map[0x03].chars[2] = u'\u00B2';
+    map[0x04].chars[2] = u'\u00B3';
+    map[0x08].chars[2] = u'{';
+    map[0x09].chars[2] = u'[';
+    map[0x0A].chars[2] = u']';
+    map[0x0B].chars[2] = u'}';
+
+    set_key(map, 0x0C, VK_OEM_4, u'\u00DF', u'?', u'\\');
+    set_key(map, 0x0D, VK_OEM_6);
+    set_letter(map, 0x15, 'z');
+    set_letter(map, 0x2C, 'y');
+    set_key(map, 0x1A, VK_OEM_1, u'\u00FC', u'\u00DC');
+    set_key(map, 0x1B, VK_OEM_PLUS, u'+', u'*', u'~');
+    set_key(map, 0x27, VK_OEM_3, u'\u00F6', u'\u00D6');
+    set_key(map, 0x28, VK_OEM_7, u'\u00E4', u'\u00C4');
+    set_key(map, 0x29, VK_OEM_5, 0, u'\u00B0');
+    set_key(map, 0x2B, VK_OEM_2, u'#', u'\'');
+    set_key(map, 0x33, VK_OEM_COMMA, u',', u';');
+    set_key(map, 0x34, VK_OEM_PERIOD, u'.', u':');
+    set_key(map, 0x35, VK_OEM_MINUS, u'-', u'_');
+    set_key(map, 0x56, VK_OEM_102, u'<', u'>', u'|');
+    map[0x10].chars[2] = u'@';
+    map[0x12].chars[2] = u'\u20AC';
+    map[0x32].chars[2] = u'\u00B5';
+    map[0x1A].is_letter = true;
+    map[0x27].is_letter = true;
+    map[0x28].is_letter = true;
+
+    return map;
+}
+
+static constexpr KeyMap make_fr_keys()
+{
+    KeyMap map = make_us_keys();
+
+    // the number row types symbols, digits need shift.
+    const char16_t normal[] = u"&\u00E9\"'(-\u00E8_\u00E7\u00E0";
+    const char16_t altgr[] = u"\0\0#{[|\0\\^@";
+    for (int i = 0; i < 10; i++)
+    {
+        map[0x02 + i].chars[1] = map[0x02 + i].chars[0];
+        map[0x02 + i].chars[0] = normal[i];
+        map[0x02 + i].chars[2] = altgr[i];
+    }
+
+    set_key(map, 0x0C, VK_OEM_4, u')', u'\u00B0', u']');
+    set_key(map, 0x0D, VK_OEM_PLUS, u'=', u'+', u'}');
+    set_letter(map, 0x10, 'a');
+    set_letter(map, 0x11, 'z');
+    set_letter(map, 0x1E, 'q');
+    set_letter(map, 0x27, 'm');
+    set_letter(map, 0x2C, 'w');
+    set_key(map, 0x1A, VK_OEM_6);
+    set_key(map, 0x1B, VK_OEM_1, u'$', u'\u00A3');
+    set_key(map, 0x28, VK_OEM_3, u'\u00F9', u'%');
+    set_key(map, 0x29, VK_OEM_7, u'\u00B2');
+    set_key(map, 0x2B, VK_OEM_5, u'*', u'\u00B5');
+    set_key(map, 0x32, VK_OEM_COMMA, u',', u'?');
+    set_key(map, 0x33, VK_OEM_PERIOD, u';', u'.');
+    set_key(map, 0x34, VK_OEM_2, u':', u'/');
+    set_key(map, 0x35, VK_OEM_8, u'!', u'\u00A7');
+    set_key(map, 0x56, VK_OEM_102, u'<', u'>');
+    map[0x12].chars[2] = u'\u20AC';
+
+    return map;
+}
+
+static constexpr KeyMap US_KEYS = make_us_keys();
+static constexpr KeyMap UK_KEYS = make_uk_keys();
+static constexpr KeyMap DE_KEYS = make_de_keys();
+static constexpr KeyMap FR_KEYS = make_fr_keys();
+
+static const KeyMap& get_key_map(KeyboardLayout layout)
+{
+    switch (layout)
+    {
+        case kKeyboardLayoutUK:
+            return UK_KEYS;
+        case kKeyboardLayoutDE:
+            return DE_KEYS;
+        case kKeyboardLayoutFR:
+            return FR_KEYS;
+        default:
+            return US_KEYS;
+    }
+}
+
+KeyTranslation TranslateKey(KeyboardLayout layout, int scan_code, uint32_t flags, bool is_altgr)
+{
+    bool is_extended = (scan_code & 0xFF00) == 0xE000;
+    int index = (scan_code & 0x7F) | (is_extended ? KEY_EXTENDED : 0);
+    const KeyInfo& info = get_key_map(layout)[index];
+
+    KeyTranslation translation = {};
+    translation.windows_key_code = info.key_code;
+    translation.flags = info.is_keypad ? EVENTFLAG_IS_KEY_PAD : 0;
+    translation.unmodified_character = info.chars[0];
+
+#if defined(WIN32)
+    translation.native_key_code = ((scan_code & 0xFF) << 16) | (is_extended ? 1 << 24 : 0) | 1;
+#elif defined(LINUX)
+    translation.native_key_code = info.evdev_code != 0 ? info.evdev_code + 8 : scan_code;
+#else
+    translation.native_key_code = scan_code;
+#endif
+
+    // with num lock off the numpad moves the caret instead of typing digits.
+    if (info.numpad_key_code != 0)
+    {
+        if (flags & EVENTFLAG_NUM_LOCK_ON)
+        {
+            translation.windows_key_code = info.numpad_key_code;
+            translation.character = info.chars[0];
+        }
+        else
+        {
+            translation.unmodified_character = 0;
+        }
+
+        return translation;
+    }
+
+    // windows reports AltGr as ctrl + alt.
+    uint32_t ctrl_alt = EVENTFLAG_CONTROL_DOWN | EVENTFLAG_ALT_DOWN;
+    if ((is_altgr || (flags & ctrl_alt) == ctrl_alt) && info.chars[2] != 0)
+    {
+        translation.character = info.chars[2];
+        translation.flags |= EVENTFLAG_ALTGR_DOWN;
+    }
+    else if (!(flags & (ctrl_alt | EVENTFLAG_COMMAND_DOWN)))
+    {
+        // shortcuts do not type.
+        bool is_shift = flags & EVENTFLAG_SHIFT_DOWN;
+        if (info.is_letter && (flags & EVENTFLAG_CAPS_LOCK_ON))
+        {
+            is_shift = !is_shift;
+        }
+
+        translation.character = info.chars[is_shift ? 1 : 0];
+    }
+
+    return translation;
+}
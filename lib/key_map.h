@@ -0,0 +1,38 @@
+//
+//  key_map.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/1.
+//
+
+#ifndef LIBWEBVIEW_KEY_MAP_H
+#define LIBWEBVIEW_KEY_MAP_H
+#pragma once
+
+#include <stdint.h>
+
+#include "webview.h"
+
+typedef struct
+{
+    // windows virtual key code, also what chromium expects on linux.
+    int windows_key_code;
+    // the platform key code: the lParam on windows, the X keycode on linux.
+    int native_key_code;
+    // the character the key types with the current modifiers and without
+    // them, 0 if the key does not type one.
+    char16_t character;
+    char16_t unmodified_character;
+    // cef_event_flags_t the key adds to the event.
+    uint32_t flags;
+} KeyTranslation;
+
+//
+// Translate a set 1 scan code, extended keys carry the 0xE0 prefix in the
+// second byte. |flags| are the cef_event_flags_t of the event, |is_altgr|
+// selects the third level characters of the layout. The lookup goes through
+// tables generated at compile time, it never allocates.
+//
+KeyTranslation TranslateKey(KeyboardLayout layout, int scan_code, uint32_t flags, bool is_altgr);
+
+#endif  // LIBWEBVIEW_KEY_MAP_H
@@ -0,0 +1,186 @@
+//
+//  keyboard_state.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/30.
+//
+
+#include "keyboard_state.h"
+
+#include "include/cef_app.h"
+
+#ifdef WIN32
+#include "windows.h"
+#endif
+
+#ifdef CEF_X11
+#include <X11/XKBlib.h>
+
+#include <mutex>
+#endif
+
+#define KEY_LEFT_SHIFT (1 << 0)
+#define KEY_RIGHT_SHIFT (1 << 1)
+#define KEY_LEFT_CTRL (1 << 2)
+#define KEY_RIGHT_CTRL (1 << 3)
+#define KEY_LEFT_ALT (1 << 4)
+#define KEY_RIGHT_ALT (1 << 5)
+#define KEY_LEFT_META (1 << 6)
+#define KEY_RIGHT_META (1 << 7)
+#define KEY_CAPS_LOCK (1 << 8)
+#define KEY_NUM_LOCK (1 << 9)
+
+#define KEYS_LEFT (KEY_LEFT_SHIFT | KEY_LEFT_CTRL | KEY_LEFT_ALT | KEY_LEFT_META)
+#define KEYS_RIGHT (KEY_RIGHT_SHIFT | KEY_RIGHT_CTRL | KEY_RIGHT_ALT | KEY_RIGHT_META)
+
+static uint32_t key_from_scan_code(int scan_code)
+{
+    bool is_extended = (scan_code & 0xFF00) == 0xE000;
+    switch (scan_code & 0xFF)
+    {
+        case 0x2A:
+            return KEY_LEFT_SHIFT;
+        case 0x36:
+            return KEY_RIGHT_SHIFT;
+        case 0x1D:
+            return is_extended ? KEY_RIGHT_CTRL : KEY_LEFT_CTRL;
+        case 0x38:
+            return is_extended ? KEY_RIGHT_ALT : KEY_LEFT_ALT;
+        case 0x5B:
+            return KEY_LEFT_META;
+        case 0x5C:
+            return KEY_RIGHT_META;
+        case 0x3A:
+            return KEY_CAPS_LOCK;
+        case 0x45:
+            return is_extended ? 0 : KEY_NUM_LOCK;
+        default:
+            return 0;
+    }
+}
+
+#ifdef CEF_X11
+
+//
+// Opened on first use and kept for the lifetime of the process, Xlib is not
+// thread safe so every use goes through the lock.
+//
+static Display* lock_shared_display(std::unique_lock<std::mutex>& lock)
+{
+    static std::mutex mutex;
+    static Display* display = XOpenDisplay(nullptr);
+
+    lock = std::unique_lock<std::mutex>(mutex);
+    return display;
+}
+
+#endif
+
+uint32_t KeyboardState::OnKey(int scan_code, bool pressed)
+{
+    uint32_t key = key_from_scan_code(scan_code);
+    uint32_t flags = 0;
+
+    if (pressed)
+    {
+        if (_keys & key)
+        {
+            flags |= EVENTFLAG_IS_REPEAT;
+        }
+        else if (key == KEY_CAPS_LOCK || key == KEY_NUM_LOCK)
+        {
+            _locks ^= key;
+        }
+
+        _keys |= key;
+    }
+    else
+    {
+        _keys &= ~key;
+    }
+
+    if (key & KEYS_LEFT)
+    {
+        flags |= EVENTFLAG_IS_LEFT;
+    }
+    else if (key & KEYS_RIGHT)
+    {
+        flags |= EVENTFLAG_IS_RIGHT;
+    }
+
+    return flags | Flags();
+}
+
+uint32_t KeyboardState::Flags()
+{
+    uint32_t flags = 0;
+    if (_keys & (KEY_LEFT_SHIFT | KEY_RIGHT_SHIFT))
+    {
+        flags |= EVENTFLAG_SHIFT_DOWN;
+    }
+
+    if (_keys & (KEY_LEFT_CTRL | KEY_RIGHT_CTRL))
+    {
+        flags |= EVENTFLAG_CONTROL_DOWN;
+    }
+
+    if (_keys & (KEY_LEFT_ALT | KEY_RIGHT_ALT))
+    {
+        flags |= EVENTFLAG_ALT_DOWN;
+    }
+
+    if (_keys & (KEY_LEFT_META | KEY_RIGHT_META))
+    {
+        flags |= EVENTFLAG_COMMAND_DOWN;
+    }
+
+    if (_locks & KEY_CAPS_LOCK)
+    {
+        flags |= EVENTFLAG_CAPS_LOCK_ON;
+    }
+
+    if (_locks & KEY_NUM_LOCK)
+    {
+        flags |= EVENTFLAG_NUM_LOCK_ON;
+    }
+
+    return flags;
+}
+
+bool KeyboardState::IsAltGraph()
+{
+    return _keys & KEY_RIGHT_ALT;
+}
+
+bool KeyboardState::Sync()
+{
+    bool is_caps_lock_on = false;
+    bool is_num_lock_on = false;
+
+#if defined(WIN32)
+    is_caps_lock_on = (GetKeyState(VK_CAPITAL) & 0x0001) != 0;
+    is_num_lock_on = (GetKeyState(VK_NUMLOCK) & 0x0001) != 0;
+#elif defined(CEF_X11)
+    std::unique_lock<std::mutex> lock;
+    Display* display = lock_shared_display(lock);
+    if (display == nullptr)
+    {
+        return false;
+    }
+
+    XkbStateRec state;
+    if (XkbGetState(display, XkbUseCoreKbd, &state) != Success)
+    {
+        return false;
+    }
+
+    // num lock is conventionally bound to Mod2.
+    is_caps_lock_on = state.locked_mods & LockMask;
+    is_num_lock_on = state.locked_mods & Mod2Mask;
+#else
+    return false;
+#endif
+
+    _locks = (is_caps_lock_on ? KEY_CAPS_LOCK : 0) | (is_num_lock_on ? KEY_NUM_LOCK : 0);
+    return true;
+}
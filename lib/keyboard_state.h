@@ -0,0 +1,46 @@
+//
+//  keyboard_state.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/30.
+//
+
+#ifndef LIBWEBVIEW_KEYBOARD_STATE_H
+#define LIBWEBVIEW_KEYBOARD_STATE_H
+#pragma once
+
+#include <stdint.h>
+
+//
+// Tracks the modifier keys that are held and the lock keys that are on from
+// the key events sent to the browser, as cef_event_flags_t bits. Keeping the
+// state in memory means a key event never waits for the windowing system, it
+// is only asked for the lock state by an explicit |Sync|.
+//
+class KeyboardState
+{
+public:
+    //
+    // Update the state with a key event, |scan_code| is a set 1 scan code,
+    // extended keys can carry the 0xE0 prefix in the second byte. Returns the
+    // flags the event has to carry.
+    //
+    uint32_t OnKey(int scan_code, bool pressed);
+    uint32_t Flags();
+    // right alt types the third level characters on most layouts.
+    bool IsAltGraph();
+
+    //
+    // Take the caps lock and num lock state from the system, through one X
+    // connection shared by all browsers on linux. Returns false if the state
+    // is not available.
+    //
+    bool Sync();
+
+private:
+    // the held modifier keys, one bit per physical key.
+    uint32_t _keys = 0;
+    uint32_t _locks = 0;
+};
+
+#endif  // LIBWEBVIEW_KEYBOARD_STATE_H
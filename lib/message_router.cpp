@@ -13,6 +13,47 @@
 
 #include "message_router.h"
 
+#include "shared_message.h"
+
+static CefRefPtr<CefProcessMessage> create_message(std::string& payload)
+{
+    auto msg = SharedMessage::Create(
+        "__innerMessageRouter", 0, false, payload.data(), payload.size());
+    if (msg)
+    {
+        return msg;
+    }
+
+    msg = CefProcessMessage::Create("__innerMessageRouter");
+    CefRefPtr<CefListValue> args = msg->GetArgumentList();
+    args->SetSize(1);
+    args->SetString(0, payload);
+    return msg;
+}
+
+// nothing is read from a broken region or a malformed argument list.
+static std::optional<std::string> read_payload(CefRefPtr<CefProcessMessage> msg)
+{
+    SharedMessage shared;
+    if (shared.Read(msg))
+    {
+        return shared.String();
+    }
+
+    if (msg->GetSharedMemoryRegion())
+    {
+        return std::nullopt;
+    }
+
+    CefRefPtr<CefListValue> args = msg->GetArgumentList();
+    if (!args || args->GetSize() != 1)
+    {
+        return std::nullopt;
+    }
+
+    return args->GetString(0).ToString();
+}
+
 void MessageRouter::Send(int source_id, std::string& msg)
 {
     std::lock_guard<std::mutex> guard(_mutex);
@@ -83,9 +124,13 @@ void MessageRouterMaster::OnMessage(CefRefPtr<CefProcessMessage> msg)
         return;
     }
 
-    auto args = msg->GetArgumentList();
-    std::string payload = args->GetString(0);
-    _router->Send(_id, payload);
+    auto payload = read_payload(msg);
+    if (!payload.has_value())
+    {
+        return;
+    }
+
+    _router->Send(_id, payload.value());
 }
 
 void MessageRouterMaster::_Send(std::string& payload)
@@ -100,10 +145,7 @@ void MessageRouterMaster::_Send(std::string& payload)
         return;
     }
 
-    auto msg = CefProcessMessage::Create("__innerMessageRouter");
-    CefRefPtr<CefListValue> args = msg->GetArgumentList();
-    args->SetSize(1);
-    args->SetString(0, payload);
+    auto msg = create_message(payload);
     _browser.value()->GetMainFrame()->SendProcessMessage(PID_RENDERER, msg);
 }
 
@@ -129,10 +171,7 @@ void MessageRouterHost::Broadcast(std::string& payload)
         return;
     }
 
-    auto msg = CefProcessMessage::Create("__innerMessageRouter");
-    CefRefPtr<CefListValue> args = msg->GetArgumentList();
-    args->SetSize(1);
-    args->SetString(0, payload);
+    auto msg = create_message(payload);
     _browser.value()->GetMainFrame()->SendProcessMessage(PID_BROWSER, msg);
 }
 
@@ -163,9 +202,13 @@ void MessageRouterHost::OnMessage(CefRefPtr<CefProcessMessage> msg)
         return;
     }
 
-    auto args = msg->GetArgumentList();
-    std::string payload = args->GetString(0);
-    _handler.value()(payload);
+    auto payload = read_payload(msg);
+    if (!payload.has_value())
+    {
+        return;
+    }
+
+    _handler.value()(payload.value());
 }
 
 void MessageRouterHost::IClose()
@@ -0,0 +1,255 @@
+//
+//  pending_calls.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/5.
+//
+
+#include "pending_calls.h"
+
+#include <chrono>
+
+static inline size_t hash_seq(int seq_id)
+{
+    // sequence ids count up, the low bits pick the shard and the next ones
+    // spread the calls of a shard evenly over its slots.
+    return (size_t)((uint32_t)seq_id / PENDING_CALLS_SHARDS);
+}
+
+uint64_t PendingCalls::Now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void PendingCalls::Insert(PendingCall call)
+{
+    int seq_id = call.seq_id;
+    uint64_t deadline = call.deadline;
+    Shard& shard = _GetShard(seq_id);
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if ((shard.size + 1) * 2 > shard.slots.size())
+        {
+            _Grow(shard);
+        }
+
+        uint32_t record;
+        if (!shard.free_records.empty())
+        {
+            record = shard.free_records.back();
+            shard.free_records.pop_back();
+            shard.records[record] = std::move(call);
+        }
+        else
+        {
+            record = (uint32_t)shard.records.size();
+            shard.records.push_back(std::move(call));
+        }
+
+        size_t mask = shard.slots.size() - 1;
+        size_t index = hash_seq(seq_id) & mask;
+        while (shard.slots[index].record != EMPTY_SLOT)
+        {
+            index = (index + 1) & mask;
+        }
+
+        shard.slots[index] = Slot{ seq_id, record };
+        shard.size++;
+    }
+
+    _size.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_wheel_mutex);
+    if (_tick == 0)
+    {
+        _tick = Now() / PENDING_CALLS_TICK_MS;
+    }
+
+    // the first tick at which the deadline has passed, never the current one,
+    // the wheel already moved past it.
+    uint64_t tick = (deadline + PENDING_CALLS_TICK_MS - 1) / PENDING_CALLS_TICK_MS;
+    if (tick <= _tick)
+    {
+        tick = _tick + 1;
+    }
+
+    _wheel[tick % PENDING_CALLS_WHEEL_SLOTS].push_back(seq_id);
+}
+
+bool PendingCalls::Take(int seq_id, PendingCall& call)
+{
+    Shard& shard = _GetShard(seq_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    size_t index = _Find(shard, seq_id);
+    if (index == SIZE_MAX)
+    {
+        return false;
+    }
+
+    _Remove(shard, index, call);
+    _size.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool PendingCalls::Expire(uint64_t now, std::vector<PendingCall>& expired)
+{
+    std::lock_guard<std::mutex> lock(_wheel_mutex);
+
+    // after a long stall every slot is visited once, the deadlines decide.
+    uint64_t target = now / PENDING_CALLS_TICK_MS;
+    for (size_t i = 0; _tick < target && i < PENDING_CALLS_WHEEL_SLOTS; i++)
+    {
+        _tick++;
+
+        std::vector<int>& seq_ids = _wheel[_tick % PENDING_CALLS_WHEEL_SLOTS];
+        size_t kept = 0;
+        for (int seq_id : seq_ids)
+        {
+            Shard& shard = _GetShard(seq_id);
+            std::lock_guard<std::mutex> shard_lock(shard.mutex);
+
+            // answered in the meantime.
+            size_t index = _Find(shard, seq_id);
+            if (index == SIZE_MAX)
+            {
+                continue;
+            }
+
+            // due in a later turn of the wheel.
+            if (shard.records[shard.slots[index].record].deadline > now)
+            {
+                seq_ids[kept++] = seq_id;
+                continue;
+            }
+
+            PendingCall call;
+            _Remove(shard, index, call);
+            _size.fetch_sub(1, std::memory_order_relaxed);
+            expired.push_back(std::move(call));
+        }
+
+        seq_ids.resize(kept);
+    }
+
+    if (_tick < target)
+    {
+        _tick = target;
+    }
+
+    return _size.load(std::memory_order_relaxed) > 0;
+}
+
+void PendingCalls::TakeAll(std::vector<PendingCall>& calls)
+{
+    for (auto& shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto& slot : shard.slots)
+        {
+            if (slot.record != EMPTY_SLOT)
+            {
+                calls.push_back(std::move(shard.records[slot.record]));
+                slot.record = EMPTY_SLOT;
+            }
+        }
+
+        _size.fetch_sub(shard.size, std::memory_order_relaxed);
+        shard.records.clear();
+        shard.free_records.clear();
+        shard.size = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(_wheel_mutex);
+    for (auto& seq_ids : _wheel)
+    {
+        seq_ids.clear();
+    }
+}
+
+size_t PendingCalls::Size()
+{
+    return _size.load(std::memory_order_relaxed);
+}
+
+PendingCalls::Shard& PendingCalls::_GetShard(int seq_id)
+{
+    return _shards[(uint32_t)seq_id & (PENDING_CALLS_SHARDS - 1)];
+}
+
+size_t PendingCalls::_Find(Shard& shard, int seq_id)
+{
+    if (shard.size == 0)
+    {
+        return SIZE_MAX;
+    }
+
+    size_t mask = shard.slots.size() - 1;
+    for (size_t index = hash_seq(seq_id) & mask;; index = (index + 1) & mask)
+    {
+        Slot& slot = shard.slots[index];
+        if (slot.record == EMPTY_SLOT)
+        {
+            return SIZE_MAX;
+        }
+
+        if (slot.seq_id == seq_id)
+        {
+            return index;
+        }
+    }
+}
+
+void PendingCalls::_Grow(Shard& shard)
+{
+    size_t size = shard.slots.empty() ? PENDING_CALLS_MIN_SLOTS : shard.slots.size() * 2;
+    std::vector<Slot> slots(size, Slot{ 0, EMPTY_SLOT });
+
+    size_t mask = size - 1;
+    for (auto& slot : shard.slots)
+    {
+        if (slot.record == EMPTY_SLOT)
+        {
+            continue;
+        }
+
+        size_t index = hash_seq(slot.seq_id) & mask;
+        while (slots[index].record != EMPTY_SLOT)
+        {
+            index = (index + 1) & mask;
+        }
+
+        slots[index] = slot;
+    }
+
+    shard.slots = std::move(slots);
+}
+
+void PendingCalls::_Remove(Shard& shard, size_t index, PendingCall& call)
+{
+    uint32_t record = shard.slots[index].record;
+    call = std::move(shard.records[record]);
+    // drop what the handlers captured now, not when the record is reused.
+    shard.records[record] = PendingCall{};
+    shard.free_records.push_back(record);
+    shard.size--;
+
+    // backward shift deletion: pull later entries of the probe run into the
+    // hole when their home slot allows it, so lookups need no tombstones.
+    size_t mask = shard.slots.size() - 1;
+    size_t hole = index;
+    for (size_t i = (hole + 1) & mask; shard.slots[i].record != EMPTY_SLOT; i = (i + 1) & mask)
+    {
+        size_t home = hash_seq(shard.slots[i].seq_id) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            shard.slots[hole] = shard.slots[i];
+            hole = i;
+        }
+    }
+
+    shard.slots[hole].record = EMPTY_SLOT;
+}
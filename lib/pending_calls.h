@@ -0,0 +1,104 @@
+//
+//  pending_calls.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/5.
+//
+
+#ifndef LIBWEBVIEW_PENDING_CALLS_H
+#define LIBWEBVIEW_PENDING_CALLS_H
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// shards of the table, a power of two. consecutive calls land in different
+// shards, so concurrent callers rarely wait for the same lock.
+#define PENDING_CALLS_SHARDS 16
+// slots a shard starts with, a power of two, it doubles when half full.
+#define PENDING_CALLS_MIN_SLOTS 16
+// resolution of the timing wheel and its number of slots, deadlines further
+// out than one turn of the wheel wait for later turns.
+#define PENDING_CALLS_TICK_MS 100
+#define PENDING_CALLS_WHEEL_SLOTS 128
+// a call that got no response in this time fails, the same as the timeout of
+// the rust side.
+#define PENDING_CALLS_TIMEOUT_MS 10000
+
+typedef struct
+{
+    int seq_id;
+    // monotonic clock in milliseconds.
+    uint64_t deadline;
+    // only the handler of the kind of the call is set.
+    std::function<void(std::string&, bool)> handler;
+    std::function<void(std::vector<uint8_t>&, bool)> binary_handler;
+} PendingCall;
+
+//
+// The calls that wait for a response, by sequence id. Every shard keeps its
+// calls in a slab of records that are reused once answered, found through an
+// open addressing index. A timing wheel holds the sequence ids by deadline,
+// so expiring calls only looks at the slot of the current tick.
+//
+// Any thread can insert and take calls, |Expire| is called by one thread.
+//
+class PendingCalls
+{
+public:
+    static uint64_t Now();
+
+    void Insert(PendingCall call);
+
+    //
+    // Returns false if the call is not pending, it was answered or expired
+    // already. A call is taken exactly once.
+    //
+    bool Take(int seq_id, PendingCall& call);
+
+    //
+    // Take the calls whose deadline has passed by |now|. Returns false if no
+    // call is pending after that.
+    //
+    bool Expire(uint64_t now, std::vector<PendingCall>& expired);
+    void TakeAll(std::vector<PendingCall>& calls);
+    size_t Size();
+
+private:
+    typedef struct
+    {
+        int seq_id;
+        // index of the record in the slab, |EMPTY_SLOT| if the slot is free.
+        uint32_t record;
+    } Slot;
+
+    typedef struct
+    {
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::vector<PendingCall> records;
+        std::vector<uint32_t> free_records;
+        size_t size = 0;
+    } Shard;
+
+    static const uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    Shard& _GetShard(int seq_id);
+    static size_t _Find(Shard& shard, int seq_id);
+    static void _Grow(Shard& shard);
+    static void _Remove(Shard& shard, size_t index, PendingCall& call);
+
+    Shard _shards[PENDING_CALLS_SHARDS];
+    std::atomic<size_t> _size = 0;
+
+    std::mutex _wheel_mutex;
+    std::vector<int> _wheel[PENDING_CALLS_WHEEL_SLOTS];
+    uint64_t _tick = 0;
+};
+
+#endif  // LIBWEBVIEW_PENDING_CALLS_H
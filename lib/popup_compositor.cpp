@@ -0,0 +1,189 @@
+//
+//  popup_compositor.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/22.
+//
+
+#include "popup_compositor.h"
+
+#include <cmath>
+
+#include "simd.h"
+
+PopupCompositor::PopupCompositor(float device_scale_factor)
+    : _device_scale_factor(device_scale_factor)
+{
+}
+
+void PopupCompositor::Show(bool show)
+{
+    if (show == _is_visible)
+    {
+        return;
+    }
+
+    if (!show && _has_popup)
+    {
+        _Damage(Rect{ _rect.x, _rect.y, _popup_width, _popup_height });
+    }
+
+    // The view copy is refreshed from the next view paint, which always
+    // carries the whole view.
+    _is_visible = show;
+    _has_popup = false;
+    _has_view = false;
+}
+
+void PopupCompositor::SetRect(const Rect& rect)
+{
+    // The old popup contents do not match the new geometry, so the popup is
+    // left out of the frame until it has been painted again.
+    if (_has_popup)
+    {
+        _Damage(Rect{ _rect.x, _rect.y, _popup_width, _popup_height });
+        _has_popup = false;
+    }
+
+    _rect.x = (int)std::lround(rect.x * _device_scale_factor);
+    _rect.y = (int)std::lround(rect.y * _device_scale_factor);
+    _rect.width = (int)std::lround(rect.width * _device_scale_factor);
+    _rect.height = (int)std::lround(rect.height * _device_scale_factor);
+}
+
+const void* PopupCompositor::PaintView(const void* buffer,
+                                       int width,
+                                       int height,
+                                       std::vector<Rect>& rects)
+{
+    if (!_is_visible)
+    {
+        RectListMerge(rects, _damage.data(), _damage.size());
+        _damage.clear();
+        return buffer;
+    }
+
+    const uint8_t* src = (const uint8_t*)buffer;
+    Rect popup = { _rect.x, _rect.y, _popup_width, _popup_height };
+
+    if (!_has_view || width != _width || height != _height)
+    {
+        size_t size = (size_t)width * height * FRAME_PIXEL_SIZE;
+        FrameBufferResize(_view, size);
+        FrameBufferResize(_composite, size);
+        memcpy(_view.data(), src, size);
+        memcpy(_composite.data(), src, size);
+
+        _width = width;
+        _height = height;
+        _has_view = true;
+        _damage.clear();
+
+        if (_has_popup)
+        {
+            _Compose(popup);
+        }
+
+        rects.clear();
+        rects.push_back({ 0, 0, width, height });
+        return _composite.data();
+    }
+
+    for (auto& rect : rects)
+    {
+        FrameCopyRect(_view.data(), src, width, height, rect);
+        FrameCopyRect(_composite.data(), src, width, height, rect);
+        if (_has_popup)
+        {
+            _Compose(RectIntersect(rect, popup));
+        }
+    }
+
+    for (auto& rect : _damage)
+    {
+        FrameCopyRect(_composite.data(), _view.data(), width, height, rect);
+        if (_has_popup)
+        {
+            _Compose(RectIntersect(rect, popup));
+        }
+    }
+
+    RectListMerge(rects, _damage.data(), _damage.size());
+    _damage.clear();
+    return _composite.data();
+}
+
+const void* PopupCompositor::PaintPopup(const void* buffer,
+                                        int width,
+                                        int height,
+                                        std::vector<Rect>& rects)
+{
+    FrameBufferResize(_popup, (size_t)width * height * FRAME_PIXEL_SIZE);
+    memcpy(_popup.data(), buffer, _popup.size());
+    _popup_width = width;
+    _popup_height = height;
+    _has_popup = true;
+
+    if (!_is_visible || !_has_view)
+    {
+        return nullptr;
+    }
+
+    Rect popup = RectIntersect(Rect{ _rect.x, _rect.y, width, height },
+                               Rect{ 0, 0, _width, _height });
+
+    rects.clear();
+    for (auto& rect : _damage)
+    {
+        FrameCopyRect(_composite.data(), _view.data(), _width, _height, rect);
+        rects.push_back(rect);
+    }
+
+    _damage.clear();
+    if (!RectIsEmpty(popup))
+    {
+        // blending is not idempotent, so start over from the plain view.
+        FrameCopyRect(_composite.data(), _view.data(), _width, _height, popup);
+        _Compose(popup);
+        rects.push_back(popup);
+    }
+
+    return rects.empty() ? nullptr : _composite.data();
+}
+
+int PopupCompositor::Width()
+{
+    return _width;
+}
+
+int PopupCompositor::Height()
+{
+    return _height;
+}
+
+void PopupCompositor::_Damage(const Rect& rect)
+{
+    Rect clip = RectIntersect(rect, Rect{ 0, 0, _width, _height });
+    if (!RectIsEmpty(clip))
+    {
+        _damage.push_back(clip);
+    }
+}
+
+void PopupCompositor::_Compose(const Rect& rect)
+{
+    Rect clip = RectIntersect(rect, Rect{ _rect.x, _rect.y, _popup_width, _popup_height });
+    clip = RectIntersect(clip, Rect{ 0, 0, _width, _height });
+    if (RectIsEmpty(clip))
+    {
+        return;
+    }
+
+    for (int y = clip.y; y < clip.y + clip.height; y++)
+    {
+        const uint8_t* src = _popup.data() +
+            ((size_t)(y - _rect.y) * _popup_width + (clip.x - _rect.x)) * FRAME_PIXEL_SIZE;
+        uint8_t* dst = _composite.data() + ((size_t)y * _width + clip.x) * FRAME_PIXEL_SIZE;
+        SimdBlend(src, dst, clip.width);
+    }
+}
@@ -0,0 +1,70 @@
+//
+//  popup_compositor.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/22.
+//
+
+#ifndef LIBWEBVIEW_POPUP_COMPOSITOR_H
+#define LIBWEBVIEW_POPUP_COMPOSITOR_H
+#pragma once
+
+#include <vector>
+
+#include "frame.h"
+#include "webview.h"
+
+//
+// Offscreen browsers paint popup widgets (select dropdowns, autofill) into a
+// separate buffer. The compositor keeps that buffer and blends it into the view
+// frame, touching only the dirty rects of the view and the popup rect. While
+// no popup is shown the view frames are passed through untouched.
+//
+class PopupCompositor
+{
+public:
+    PopupCompositor(float device_scale_factor);
+
+    //
+    // Both are called on the CEF UI thread, |rect| is in view coordinates.
+    //
+    void Show(bool show);
+    void SetRect(const Rect& rect);
+
+    //
+    // Returns the frame to deliver for a view paint, either |buffer| itself or
+    // the composited frame. |rects| get the popup regions that changed added.
+    //
+    const void* PaintView(const void* buffer, int width, int height, std::vector<Rect>& rects);
+
+    //
+    // Returns the composited frame for a popup paint, or null if there is no
+    // view frame to composite onto yet. |rects| are replaced by the popup rect.
+    //
+    const void* PaintPopup(const void* buffer, int width, int height, std::vector<Rect>& rects);
+
+    int Width();
+    int Height();
+
+private:
+    void _Damage(const Rect& rect);
+    void _Compose(const Rect& rect);
+
+    float _device_scale_factor;
+    bool _is_visible = false;
+    bool _has_popup = false;
+    bool _has_view = false;
+    Rect _rect = { 0, 0, 0, 0 };
+    int _popup_width = 0;
+    int _popup_height = 0;
+    int _width = 0;
+    int _height = 0;
+    // regions of the delivered frame that still show an old popup position.
+    std::vector<Rect> _damage;
+    std::vector<uint8_t> _popup;
+    // the plain view frame and the view frame with the popup on top of it.
+    std::vector<uint8_t> _view;
+    std::vector<uint8_t> _composite;
+};
+
+#endif  // LIBWEBVIEW_POPUP_COMPOSITOR_H
@@ -0,0 +1,292 @@
+//
+//  recorder.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/28.
+//
+
+#include "recorder.h"
+
+Recorder::~Recorder()
+{
+    if (_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _is_stopped = true;
+        }
+
+        // the writer drains the queue before it exits.
+        _cond.notify_one();
+        _thread.join();
+    }
+
+    if (_file != nullptr)
+    {
+        fclose(_file);
+    }
+}
+
+bool Recorder::Open(const char* path, bool with_frames)
+{
+    _with_frames = with_frames;
+    _file = fopen(path, "wb");
+    if (_file == nullptr)
+    {
+        return false;
+    }
+
+    RecordFileHeader header;
+    header.magic = RECORD_MAGIC;
+    header.version = RECORD_VERSION;
+    if (fwrite(&header, sizeof(header), 1, _file) != 1)
+    {
+        return false;
+    }
+
+    _start = std::chrono::steady_clock::now();
+    _thread = std::thread(&Recorder::_Run, this);
+    return true;
+}
+
+void Recorder::WriteFrame(const void* buffer,
+                          int width,
+                          int height,
+                          const std::vector<Rect>& rects)
+{
+    if (!_with_frames || width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    uint64_t timestamp = _Timestamp();
+    bool is_keyframe = _need_keyframe || width != _width || height != _height ||
+        timestamp - _keyframe_timestamp >= RECORDER_KEYFRAME_INTERVAL_MS * 1000000ull;
+
+    std::unique_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_pending_frames >= RECORDER_MAX_PENDING_FRAMES)
+        {
+            // the dropped damage is lost, only a keyframe can recover from it.
+            _need_keyframe = true;
+            return;
+        }
+
+        _pending_frames++;
+        job = _TakeJob();
+    }
+
+    job->type = is_keyframe ? kRecordKeyframe : kRecordDelta;
+    job->timestamp = timestamp;
+    job->rects.clear();
+
+    Rect view = { 0, 0, width, height };
+    if (is_keyframe)
+    {
+        job->rects.push_back({ 0, 0, width, height });
+    }
+    else
+    {
+        for (auto& rect : rects)
+        {
+            Rect clip = RectIntersect(rect, view);
+            if (!RectIsEmpty(clip))
+            {
+                job->rects.push_back({ clip.x, clip.y, clip.width, clip.height });
+            }
+        }
+    }
+
+    size_t count = 0;
+    for (auto& rect : job->rects)
+    {
+        count += (size_t)rect.width * rect.height;
+    }
+
+    job->frame.width = width;
+    job->frame.height = height;
+    job->frame.rects_size = (uint32_t)job->rects.size();
+    job->frame.reserved = 0;
+    FrameBufferResize(job->pixels, count * FRAME_PIXEL_SIZE);
+
+    const uint8_t* src = (const uint8_t*)buffer;
+    size_t stride = (size_t)width * FRAME_PIXEL_SIZE;
+    uint8_t* dst = job->pixels.data();
+    for (auto& rect : job->rects)
+    {
+        size_t row_size = (size_t)rect.width * FRAME_PIXEL_SIZE;
+        for (int row = 0; row < rect.height; row++)
+        {
+            memcpy(dst, src + (size_t)(rect.y + row) * stride + (size_t)rect.x * FRAME_PIXEL_SIZE,
+                   row_size);
+            dst += row_size;
+        }
+    }
+
+    _Push(std::move(job));
+
+    _width = width;
+    _height = height;
+    if (is_keyframe)
+    {
+        _need_keyframe = false;
+        _keyframe_timestamp = timestamp;
+    }
+}
+
+void Recorder::WriteInput(const InputEvent& event)
+{
+    uint64_t timestamp = _Timestamp();
+    auto job = _TakeInputJob();
+    if (!job)
+    {
+        return;
+    }
+
+    job->type = kRecordInput;
+    job->timestamp = timestamp;
+    job->input.type = event.type;
+    job->input.x = event.x;
+    job->input.y = event.y;
+    job->input.code = event.code;
+    job->input.flags = event.flags;
+    _Push(std::move(job));
+}
+
+void Recorder::WriteText(InputTextType type, const std::string& text, int x, int y)
+{
+    uint64_t timestamp = _Timestamp();
+    auto job = _TakeInputJob();
+    if (!job)
+    {
+        return;
+    }
+
+    job->type = kRecordText;
+    job->timestamp = timestamp;
+    job->text_header.type = type;
+    job->text_header.x = x;
+    job->text_header.y = y;
+    job->text_header.size = (uint32_t)text.size();
+    job->text = text;
+    _Push(std::move(job));
+}
+
+uint64_t Recorder::_Timestamp()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - _start)
+        .count();
+}
+
+// returns null when too many input events are pending.
+std::unique_ptr<Recorder::Job> Recorder::_TakeInputJob()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_pending_inputs >= RECORDER_MAX_PENDING_INPUTS)
+    {
+        return nullptr;
+    }
+
+    _pending_inputs++;
+    return _TakeJob();
+}
+
+// called with |_mutex| held.
+std::unique_ptr<Recorder::Job> Recorder::_TakeJob()
+{
+    if (_pool.empty())
+    {
+        return std::make_unique<Job>();
+    }
+
+    auto job = std::move(_pool.back());
+    _pool.pop_back();
+    return job;
+}
+
+void Recorder::_Push(std::unique_ptr<Job> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+
+    _cond.notify_one();
+}
+
+void Recorder::_Run()
+{
+    bool is_failed = false;
+
+    for (;;)
+    {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [&] { return _is_stopped || !_jobs.empty(); });
+            if (_jobs.empty())
+            {
+                break;
+            }
+
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        // keep draining after a write error so the paint path never stalls.
+        if (!is_failed)
+        {
+            is_failed = !_Write(*job);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (job->type == kRecordInput || job->type == kRecordText)
+        {
+            _pending_inputs--;
+        }
+        else
+        {
+            _pending_frames--;
+        }
+
+        _pool.push_back(std::move(job));
+    }
+
+    fflush(_file);
+}
+
+bool Recorder::_Write(Job& job)
+{
+    RecordHeader header = {};
+    header.type = (uint8_t)job.type;
+    header.timestamp = job.timestamp;
+
+    if (job.type == kRecordInput)
+    {
+        header.size = sizeof(job.input);
+        return fwrite(&header, sizeof(header), 1, _file) == 1 &&
+            fwrite(&job.input, sizeof(job.input), 1, _file) == 1;
+    }
+
+    if (job.type == kRecordText)
+    {
+        header.size = (uint32_t)(sizeof(job.text_header) + job.text.size());
+        return fwrite(&header, sizeof(header), 1, _file) == 1 &&
+            fwrite(&job.text_header, sizeof(job.text_header), 1, _file) == 1 &&
+            (job.text.empty() || fwrite(job.text.data(), job.text.size(), 1, _file) == 1);
+    }
+
+    _encoded.clear();
+    RecordEncode(job.pixels.data(), job.pixels.size() / FRAME_PIXEL_SIZE, _encoded);
+
+    size_t rects_size = job.rects.size() * sizeof(RecordRect);
+    header.size = (uint32_t)(sizeof(job.frame) + rects_size + _encoded.size());
+    return fwrite(&header, sizeof(header), 1, _file) == 1 &&
+        fwrite(&job.frame, sizeof(job.frame), 1, _file) == 1 &&
+        (rects_size == 0 || fwrite(job.rects.data(), rects_size, 1, _file) == 1) &&
+        (_encoded.empty() || fwrite(_encoded.data(), _encoded.size(), 1, _file) == 1);
+}
@@ -0,0 +1,101 @@
+//
+//  recorder.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/28.
+//
+
+#ifndef LIBWEBVIEW_RECORDER_H
+#define LIBWEBVIEW_RECORDER_H
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame.h"
+#include "recording.h"
+
+// frames waiting for the writer thread before new frames are dropped.
+#define RECORDER_MAX_PENDING_FRAMES 4
+// input events waiting for the writer thread before new events are dropped.
+#define RECORDER_MAX_PENDING_INPUTS 1024
+// a keyframe is written at least this often so that seeking stays cheap.
+#define RECORDER_KEYFRAME_INTERVAL_MS 2000
+
+//
+// Writes the painted frames and the input events into a recording file, see
+// recording.h for the format. Without |with_frames| only the input is
+// written, which makes a compact log to replay against a browser. The paint
+// path only copies the pixels under the dirty rects into a pooled buffer and
+// queues them, encoding and file I/O happen on a writer thread. When the
+// writer falls behind frames are dropped instead of waiting, and the next
+// frame is written as a keyframe.
+//
+class Recorder
+{
+public:
+    ~Recorder();
+
+    bool Open(const char* path, bool with_frames);
+
+    //
+    // Queue a BGRA frame, only called on the CEF UI thread.
+    //
+    void WriteFrame(const void* buffer, int width, int height, const std::vector<Rect>& rects);
+
+    //
+    // Queue an input event, can be called from any thread.
+    //
+    void WriteInput(const InputEvent& event);
+    void WriteText(InputTextType type, const std::string& text, int x, int y);
+
+private:
+    typedef struct
+    {
+        RecordType type;
+        uint64_t timestamp;
+        RecordFrame frame;
+        std::vector<RecordRect> rects;
+        std::vector<uint8_t> pixels;
+        RecordInput input;
+        RecordText text_header;
+        std::string text;
+    } Job;
+
+    uint64_t _Timestamp();
+    std::unique_ptr<Job> _TakeInputJob();
+    std::unique_ptr<Job> _TakeJob();
+    void _Push(std::unique_ptr<Job> job);
+    void _Run();
+    bool _Write(Job& job);
+
+    FILE* _file = nullptr;
+    bool _with_frames = true;
+    std::thread _thread;
+    std::chrono::steady_clock::time_point _start;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<std::unique_ptr<Job>> _jobs;
+    std::vector<std::unique_ptr<Job>> _pool;
+    size_t _pending_frames = 0;
+    size_t _pending_inputs = 0;
+    bool _is_stopped = false;
+
+    // only touched on the CEF UI thread.
+    int _width = 0;
+    int _height = 0;
+    bool _need_keyframe = true;
+    uint64_t _keyframe_timestamp = 0;
+
+    // only touched on the writer thread.
+    std::vector<uint8_t> _encoded;
+};
+
+#endif  // LIBWEBVIEW_RECORDER_H
@@ -0,0 +1,344 @@
+//
+//  recording.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/28.
+//
+
+#include "recording.h"
+
+#include <string.h>
+
+#define OP_INDEX 0x00
+#define OP_DIFF 0x40
+#define OP_LUMA 0x80
+#define OP_RUN 0xC0
+#define OP_RGB 0xFE
+#define OP_RGBA 0xFF
+#define OP_MASK 0xC0
+#define MAX_RUN 62
+
+// frames larger than this are treated as corrupt by the reader.
+#define MAX_DIMENSION 16384
+
+typedef struct
+{
+    uint8_t b, g, r, a;
+} Pixel;
+
+static inline bool pixel_equal(const Pixel& a, const Pixel& b)
+{
+    return a.b == b.b && a.g == b.g && a.r == b.r && a.a == b.a;
+}
+
+static inline int pixel_hash(const Pixel& px)
+{
+    return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+}
+
+void RecordEncode(const uint8_t* pixels, size_t count, std::vector<uint8_t>& out)
+{
+    Pixel index[64] = {};
+    Pixel prev = { 0, 0, 0, 255 };
+    int run = 0;
+
+    // the worst case is a full RGBA op for every pixel.
+    size_t offset = out.size();
+    out.resize(offset + count * 5);
+    uint8_t* dst = out.data() + offset;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Pixel px;
+        memcpy(&px, pixels + i * 4, 4);
+
+        if (pixel_equal(px, prev))
+        {
+            if (++run == MAX_RUN)
+            {
+                *dst++ = OP_RUN | (run - 1);
+                run = 0;
+            }
+
+            continue;
+        }
+
+        if (run > 0)
+        {
+            *dst++ = OP_RUN | (run - 1);
+            run = 0;
+        }
+
+        int hash = pixel_hash(px);
+        if (pixel_equal(index[hash], px))
+        {
+            *dst++ = OP_INDEX | hash;
+        }
+        else
+        {
+            index[hash] = px;
+
+            if (px.a == prev.a)
+            {
+                int8_t dr = (int8_t)(px.r - prev.r);
+                int8_t dg = (int8_t)(px.g - prev.g);
+                int8_t db = (int8_t)(px.b - prev.b);
+                int8_t dr_dg = (int8_t)(dr - dg);
+                int8_t db_dg = (int8_t)(db - dg);
+
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                {
+                    *dst++ = OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+                }
+                else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 &&
+                         db_dg <= 7)
+                {
+                    *dst++ = OP_LUMA | (dg + 32);
+                    *dst++ = (dr_dg + 8) << 4 | (db_dg + 8);
+                }
+                else
+                {
+                    *dst++ = OP_RGB;
+                    *dst++ = px.r;
+                    *dst++ = px.g;
+                    *dst++ = px.b;
+                }
+            }
+            else
+            {
+                *dst++ = OP_RGBA;
+                *dst++ = px.r;
+                *dst++ = px.g;
+                *dst++ = px.b;
+                *dst++ = px.a;
+            }
+        }
+
+        prev = px;
+    }
+
+    if (run > 0)
+    {
+        *dst++ = OP_RUN | (run - 1);
+    }
+
+    out.resize(dst - out.data());
+}
+
+bool RecordDecode(const uint8_t* data, size_t size, uint8_t* pixels, size_t count)
+{
+    Pixel index[64] = {};
+    Pixel px = { 0, 0, 0, 255 };
+    size_t pos = 0;
+    size_t i = 0;
+
+    while (i < count)
+    {
+        if (pos >= size)
+        {
+            return false;
+        }
+
+        uint8_t op = data[pos++];
+        if (op == OP_RGB || op == OP_RGBA)
+        {
+            size_t length = op == OP_RGB ? 3 : 4;
+            if (size - pos < length)
+            {
+                return false;
+            }
+
+            px.r = data[pos];
+            px.g = data[pos + 1];
+            px.b = data[pos + 2];
+            if (op == OP_RGBA)
+            {
+                px.a = data[pos + 3];
+            }
+
+            pos += length;
+            index[pixel_hash(px)] = px;
+        }
+        else if ((op & OP_MASK) == OP_INDEX)
+        {
+            px = index[op];
+        }
+        else if ((op & OP_MASK) == OP_DIFF)
+        {
+            px.r += ((op >> 4) & 0x03) - 2;
+            px.g += ((op >> 2) & 0x03) - 2;
+            px.b += (op & 0x03) - 2;
+            index[pixel_hash(px)] = px;
+        }
+        else if ((op & OP_MASK) == OP_LUMA)
+        {
+            if (pos >= size)
+            {
+                return false;
+            }
+
+            int dg = (op & 0x3F) - 32;
+            uint8_t next = data[pos++];
+            px.r += dg + ((next >> 4) & 0x0F) - 8;
+            px.g += dg;
+            px.b += dg + (next & 0x0F) - 8;
+            index[pixel_hash(px)] = px;
+        }
+        else
+        {
+            size_t run = (op & 0x3F) + 1;
+            if (count - i < run)
+            {
+                return false;
+            }
+
+            for (size_t k = 0; k < run; k++)
+            {
+                memcpy(pixels + (i + k) * 4, &px, 4);
+            }
+
+            i += run;
+            continue;
+        }
+
+        memcpy(pixels + i * 4, &px, 4);
+        i++;
+    }
+
+    return pos == size;
+}
+
+bool RecordApplyFrame(RecordType type,
+                      const std::vector<uint8_t>& payload,
+                      std::vector<uint8_t>& canvas,
+                      int& width,
+                      int& height)
+{
+    RecordFrame frame;
+    if (payload.size() < sizeof(frame))
+    {
+        return false;
+    }
+
+    memcpy(&frame, payload.data(), sizeof(frame));
+    if (frame.width <= 0 || frame.height <= 0 || frame.width > MAX_DIMENSION ||
+        frame.height > MAX_DIMENSION)
+    {
+        return false;
+    }
+
+    size_t offset = sizeof(frame);
+    if (frame.rects_size > (payload.size() - offset) / sizeof(RecordRect))
+    {
+        return false;
+    }
+
+    std::vector<RecordRect> rects(frame.rects_size);
+    if (!rects.empty())
+    {
+        memcpy(rects.data(), payload.data() + offset, rects.size() * sizeof(RecordRect));
+        offset += rects.size() * sizeof(RecordRect);
+    }
+
+    size_t count = 0;
+    for (auto& rect : rects)
+    {
+        if (rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 ||
+            rect.width > frame.width - rect.x || rect.height > frame.height - rect.y)
+        {
+            return false;
+        }
+
+        count += (size_t)rect.width * rect.height;
+    }
+
+    if (type == kRecordKeyframe)
+    {
+        if (rects.size() != 1 || rects[0].width != frame.width ||
+            rects[0].height != frame.height)
+        {
+            return false;
+        }
+
+        width = frame.width;
+        height = frame.height;
+        canvas.resize((size_t)width * height * 4);
+    }
+    else if (frame.width != width || frame.height != height)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> pixels(count * 4);
+    if (!RecordDecode(payload.data() + offset, payload.size() - offset, pixels.data(), count))
+    {
+        return false;
+    }
+
+    const uint8_t* src = pixels.data();
+    size_t stride = (size_t)width * 4;
+    for (auto& rect : rects)
+    {
+        size_t row_size = (size_t)rect.width * 4;
+        for (int row = 0; row < rect.height; row++)
+        {
+            memcpy(canvas.data() + (size_t)(rect.y + row) * stride + (size_t)rect.x * 4,
+                   src,
+                   row_size);
+            src += row_size;
+        }
+    }
+
+    return true;
+}
+
+RecordReader::~RecordReader()
+{
+    if (_file != nullptr)
+    {
+        fclose(_file);
+    }
+}
+
+bool RecordReader::Open(const char* path)
+{
+    _file = fopen(path, "rb");
+    if (_file == nullptr)
+    {
+        return false;
+    }
+
+    RecordFileHeader header;
+    if (fread(&header, sizeof(header), 1, _file) != 1)
+    {
+        return false;
+    }
+
+    return header.magic == RECORD_MAGIC && header.version == RECORD_VERSION;
+}
+
+bool RecordReader::Next(RecordHeader& header, std::vector<uint8_t>* payload)
+{
+    if (fread(&header, sizeof(header), 1, _file) != 1)
+    {
+        return false;
+    }
+
+    if (payload == nullptr)
+    {
+        return fseek(_file, header.size, SEEK_CUR) == 0;
+    }
+
+    payload->resize(header.size);
+    return header.size == 0 || fread(payload->data(), header.size, 1, _file) == 1;
+}
+
+int64_t RecordReader::Tell()
+{
+    return ftell(_file);
+}
+
+bool RecordReader::Seek(int64_t offset)
+{
+    return fseek(_file, offset, SEEK_SET) == 0;
+}
@@ -0,0 +1,141 @@
+//
+//  recording.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/28.
+//
+
+#ifndef LIBWEBVIEW_RECORDING_H
+#define LIBWEBVIEW_RECORDING_H
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "input_event.h"
+
+//
+// The recording container. A file is a RecordFileHeader followed by records,
+// every record is a RecordHeader and |size| bytes of payload. All fields are
+// little endian.
+//
+// Frame records start with a RecordFrame and |rects_size| RecordRects, then
+// the pixels under the rects encoded with |RecordEncode|, rect after rect and
+// row after row. A keyframe has a single rect covering the whole frame and
+// does not depend on any earlier record, a delta only updates its rects. An
+// input record is a RecordInput, a text record is a RecordText followed by
+// |size| bytes of UTF-8. Input only recordings carry no frame records.
+//
+// This header does not depend on CEF so that the replay tool can share it.
+//
+
+#define RECORD_MAGIC 0x43525657  // "WVRC"
+#define RECORD_VERSION 1
+
+typedef enum
+{
+    kRecordKeyframe = 1,
+    kRecordDelta = 2,
+    kRecordInput = 3,
+    kRecordText = 4,
+} RecordType;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+} RecordFileHeader;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t reserved[3];
+    uint32_t size;
+    // nanoseconds since the recording started.
+    uint64_t timestamp;
+} RecordHeader;
+
+typedef struct
+{
+    int32_t width;
+    int32_t height;
+    uint32_t rects_size;
+    uint32_t reserved;
+} RecordFrame;
+
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+} RecordRect;
+
+typedef struct
+{
+    int32_t type;
+    int32_t x;
+    int32_t y;
+    int32_t code;
+    int32_t flags;
+} RecordInput;
+
+typedef struct
+{
+    int32_t type;
+    int32_t x;
+    int32_t y;
+    uint32_t size;
+} RecordText;
+
+//
+// A QOI style lossless codec for BGRA pixels: runs of the previous pixel,
+// references into a table of recently seen pixels and small channel
+// differences are all shorter than the pixel itself. Web content is mostly
+// flat colors and text, which this compresses well at memcpy like speed.
+//
+void RecordEncode(const uint8_t* pixels, size_t count, std::vector<uint8_t>& out);
+
+//
+// Decode exactly |count| pixels, returns false if the stream is truncated or
+// does not decode to |count| pixels.
+//
+bool RecordDecode(const uint8_t* data, size_t size, uint8_t* pixels, size_t count);
+
+//
+// Apply a keyframe or delta payload to |canvas|, a keyframe resizes the
+// canvas. Returns false if the payload is malformed or a delta does not fit
+// the canvas.
+//
+bool RecordApplyFrame(RecordType type,
+                      const std::vector<uint8_t>& payload,
+                      std::vector<uint8_t>& canvas,
+                      int& width,
+                      int& height);
+
+//
+// Sequential reader of a recording, records can be revisited by seeking to
+// an offset returned by |Tell| before the record was read.
+//
+class RecordReader
+{
+public:
+    ~RecordReader();
+
+    bool Open(const char* path);
+
+    //
+    // Read the next record, the payload is skipped if |payload| is null.
+    // Returns false at the end of the file or on a truncated record.
+    //
+    bool Next(RecordHeader& header, std::vector<uint8_t>* payload);
+    int64_t Tell();
+    bool Seek(int64_t offset);
+
+private:
+    FILE* _file = nullptr;
+};
+
+#endif  // LIBWEBVIEW_RECORDING_H
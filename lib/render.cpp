@@ -9,19 +9,79 @@
 
 #include <float.h>
 
+#include <chrono>
+
+#include "include/base/cef_callback.h"
+#include "include/wrapper/cef_closure_task.h"
+
 IRender::IRender(BrowserSettings* settings, BrowserObserver observer, void* ctx)
     : _settings(settings)
     , _observer(observer)
     , _ctx(ctx)
     , _width(settings->width)
     , _height(settings->height)
+    , _max_frame_rate(settings->frame_rate)
+    , _popup(settings->device_scale_factor)
+    , _last_pull(RenderMetrics::Now())
 {
     assert(settings);
+
+    if (settings->frame_store)
+    {
+        _frame_store = std::make_unique<FrameStore>(
+            settings->output_format,
+            (int)(settings->width * settings->device_scale_factor),
+            (int)(settings->height * settings->device_scale_factor));
+    }
+
+    if (settings->frame_ring_slots > 0)
+    {
+        _frame_ring = std::make_unique<FrameRing>(
+            settings->output_format,
+            settings->frame_ring_slots,
+            (int)(settings->width * settings->device_scale_factor),
+            (int)(settings->height * settings->device_scale_factor));
+    }
+
+    // the host decides when frames are produced in the external begin frame
+    // mode, so there is no rate to adapt.
+    if (settings->adaptive_frame_rate && !settings->external_begin_frame)
+    {
+        _frame_rate = std::make_unique<FrameRateController>(settings->frame_rate);
+    }
+
+    if (settings->tiled_output)
+    {
+        _tile_surface = std::make_unique<TileSurface>();
+    }
+
+    if (settings->change_filter)
+    {
+        _change_filter = std::make_unique<ChangeFilter>();
+    }
+
+    if (FrameConverter::IsRequired(settings->output_format, settings->straight_alpha))
+    {
+        _converter = std::make_unique<FrameConverter>(settings->output_format,
+                                                      settings->straight_alpha);
+    }
+
+    if (settings->trace_input)
+    {
+        _tracer = std::make_unique<InputTracer>(settings->device_scale_factor);
+    }
 }
 
 void IRender::SetBrowser(CefRefPtr<CefBrowser> browser)
 {
     _browser = browser;
+
+    if (_frame_rate)
+    {
+        CefPostDelayedTask(TID_UI,
+                           base::BindOnce(&IRender::_UpdateFrameRate, CefRefPtr<IRender>(this)),
+                           FRAME_RATE_WINDOW_MS);
+    }
 }
 
 void IRender::OnImeCompositionRangeChanged(CefRefPtr<CefBrowser> browser,
@@ -51,6 +111,29 @@ void IRender::GetViewRect(CefRefPtr<CefBrowser> browser, CefRect& rect)
     rect = CefRect(0, 0, _width, _height);
 }
 
+void IRender::OnPopupShow(CefRefPtr<CefBrowser> browser, bool show)
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    // the compositor needs a whole view frame to compose onto when showing,
+    // and has to restore the view under the popup when hiding.
+    _popup.Show(show);
+    browser->GetHost()->Invalidate(PET_VIEW);
+}
+
+void IRender::OnPopupSize(CefRefPtr<CefBrowser> browser, const CefRect& rect)
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    _popup.SetRect({ rect.x, rect.y, rect.width, rect.height });
+}
+
 void IRender::OnPaint(CefRefPtr<CefBrowser> browser,
                       PaintElementType type,
                       const RectList& dirtyRects,
@@ -68,7 +151,145 @@ void IRender::OnPaint(CefRefPtr<CefBrowser> browser,
         return;
     }
 
-    _observer.on_frame(buffer, width, height, _ctx);
+    _stamp = _metrics.OnPaint(_frame_request);
+
+    _dirty_rects.clear();
+    for (auto& dirty : dirtyRects)
+    {
+        _dirty_rects.push_back({ dirty.x, dirty.y, dirty.width, dirty.height });
+    }
+
+    if (type == PET_POPUP)
+    {
+        buffer = _popup.PaintPopup(buffer, width, height, _dirty_rects);
+        if (buffer == nullptr)
+        {
+            return;
+        }
+
+        width = _popup.Width();
+        height = _popup.Height();
+    }
+    else
+    {
+        buffer = _popup.PaintView(buffer, width, height, _dirty_rects);
+    }
+
+    _DeliverFrame(buffer, width, height);
+
+    // the frame is with the host by now, unless it was filtered, in which
+    // case no input was attributed to it.
+    if (_tracer)
+    {
+        _tracer->OnDelivered();
+    }
+}
+
+void IRender::_DeliverFrame(const void* buffer, int width, int height)
+{
+    if (_change_filter && !_change_filter->Filter(buffer, width, height, _dirty_rects))
+    {
+        _metrics.OnFiltered();
+        return;
+    }
+
+    // attributed after the change filter, which leaves only the rects whose
+    // pixels really changed.
+    if (_tracer)
+    {
+        _tracer->OnPaint(_dirty_rects, _stamp);
+    }
+
+    _metrics.OnDelivered(_dirty_rects);
+    _outputs.Process(buffer, width, height, _dirty_rects, _stamp);
+
+    {
+        std::lock_guard<std::mutex> lock(_recorder_mutex);
+        if (_recorder)
+        {
+            _recorder->WriteFrame(buffer, width, height, _dirty_rects);
+        }
+    }
+
+    // tiles are always kept in BGRA, so they are taken before the conversion.
+    if (_tile_surface)
+    {
+        _tile_surface->Write(buffer, width, height, _dirty_rects);
+    }
+
+    if (_converter)
+    {
+        buffer = _converter->Convert(buffer, width, height, _dirty_rects);
+    }
+
+    if (_frame_ring)
+    {
+        _frame_ring->Write(buffer, width, height, _dirty_rects, _stamp);
+    }
+
+    if (_tile_surface || _frame_store)
+    {
+        _CheckAutoHide();
+    }
+
+    if (_tile_surface)
+    {
+        if (_frame_rate)
+        {
+            _frame_rate->OnFrame(false);
+        }
+
+        return;
+    }
+
+    if (_frame_store)
+    {
+        bool is_consumed = _frame_store->Write(buffer, width, height, _dirty_rects, _stamp);
+        if (!is_consumed)
+        {
+            _metrics.OnDropped();
+        }
+
+        if (_frame_rate)
+        {
+            _frame_rate->OnFrame(!is_consumed);
+        }
+
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (_observer.on_frame_ex == nullptr)
+    {
+        _observer.on_frame(buffer, width, height, _ctx);
+    }
+    else
+    {
+        Frame frame;
+        frame.buf = buffer;
+        frame.size = FrameSize(_settings->output_format, width, height);
+        frame.format = _settings->output_format;
+        frame.width = width;
+        frame.height = height;
+        frame.rects = _dirty_rects.data();
+        frame.rects_size = _dirty_rects.size();
+        frame.request_id = _stamp.request_id;
+        frame.sequence = _stamp.sequence;
+        frame.timestamp = _stamp.timestamp;
+        frame.input_id = _stamp.input_id;
+        frame.input_timestamp = _stamp.input_timestamp;
+        _observer.on_frame_ex(&frame, _ctx);
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    _metrics.OnCallback(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    if (_frame_rate)
+    {
+        // a callback that takes longer than a frame interval holds up the UI
+        // thread and chromium with it.
+        _frame_rate->OnFrame(elapsed > std::chrono::milliseconds(1000 / _frame_rate->Rate()));
+    }
 }
 
 bool IRender::GetScreenInfo(CefRefPtr<CefBrowser> browser, CefScreenInfo& info)
@@ -101,13 +322,423 @@ void IRender::Resize(int width, int height)
         return;
     }
 
-    _width = width;
-    _height = height;
+    // Dragging a window resizes it far more often than frames are painted and
+    // every resize relayouts the page, so only the latest size is applied, at
+    // most once per frame interval.
+    auto interval = std::chrono::milliseconds(GetFrameInterval());
+    int64_t delay = 0;
+    {
+        std::lock_guard<std::mutex> lock(_resize_mutex);
+
+        _resize_width = width;
+        _resize_height = height;
+        if (_is_resize_pending)
+        {
+            return;
+        }
+
+        _is_resize_pending = true;
+        auto elapsed = std::chrono::steady_clock::now() - _resize_time;
+        delay = std::chrono::duration_cast<std::chrono::milliseconds>(interval - elapsed).count();
+    }
+
+    CefPostDelayedTask(TID_UI,
+                       base::BindOnce(&IRender::_ApplyResize, CefRefPtr<IRender>(this)),
+                       std::max<int64_t>(delay, 0));
+}
+
+uint32_t IRender::GetFrameInterval()
+{
+    return 1000 / std::max(_max_frame_rate.load(std::memory_order_relaxed), 1u);
+}
+
+void IRender::SetFrameRate(uint32_t frame_rate)
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        return;
+    }
+
+    _max_frame_rate.store(frame_rate, std::memory_order_relaxed);
+
+    // with the adaptive frame rate this is the upper bound of the rate.
+    if (_frame_rate)
+    {
+        _frame_rate->SetMaxRate(frame_rate);
+        frame_rate = _frame_rate->Rate();
+    }
+
+    _browser.value()->GetHost()->SetWindowlessFrameRate(frame_rate);
+}
+
+void IRender::SetVisible(bool is_visible)
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        return;
+    }
+
+    _is_visible.store(is_visible, std::memory_order_relaxed);
+    CefPostTask(TID_UI, base::BindOnce(&IRender::_UpdateVisibility, CefRefPtr<IRender>(this)));
+}
+
+uint64_t IRender::RequestFrame()
+{
+    if (is_closed)
+    {
+        return 0;
+    }
+
+    if (!_browser.has_value() || !_settings->external_begin_frame)
+    {
+        return 0;
+    }
+
+    // The begin frame is sent from the UI thread, which is also where the
+    // paints arrive, so a paint never carries the id of a request that was
+    // not sent yet.
+    uint64_t id = _request_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    CefPostTask(TID_UI,
+                base::BindOnce(&IRender::_SendBeginFrame, CefRefPtr<IRender>(this), id));
+    return id;
+}
+
+void IRender::GetRenderStats(RenderStats* stats, bool reset)
+{
+    _metrics.GetStats(stats, reset);
+
+    if (_tracer)
+    {
+        _tracer->GetStats(stats, reset);
+    }
+    else
+    {
+        stats->expired_inputs = 0;
+        stats->input_to_paint = {};
+        stats->input_to_delivered = {};
+    }
+}
+
+bool IRender::StartRecording(const char* path, bool with_frames)
+{
+    if (is_closed)
+    {
+        return false;
+    }
+
+    if (!_browser.has_value())
+    {
+        return false;
+    }
+
+    auto recorder = std::make_unique<Recorder>();
+    if (!recorder->Open(path, with_frames))
+    {
+        return false;
+    }
+
+    std::unique_ptr<Recorder> previous;
+    {
+        std::lock_guard<std::mutex> lock(_recorder_mutex);
+        previous = std::move(_recorder);
+        _recorder = std::move(recorder);
+    }
+
+    // the recording starts with a keyframe, which needs a whole frame even if
+    // the page does not change.
+    _browser.value()->GetHost()->Invalidate(PET_VIEW);
+    return true;
+}
+
+void IRender::StopRecording()
+{
+    std::unique_ptr<Recorder> recorder;
+    {
+        std::lock_guard<std::mutex> lock(_recorder_mutex);
+        recorder = std::move(_recorder);
+    }
+
+    // the queued frames are flushed outside of the lock, so the paint path
+    // does not wait for them.
+    recorder.reset();
+}
+
+void IRender::NotifyInputText(InputTextType type, const std::string& text, int x, int y)
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    _metrics.OnInput();
+    if (_tracer)
+    {
+        _tracer->OnInputText();
+    }
+
+    std::lock_guard<std::mutex> lock(_recorder_mutex);
+    if (_recorder)
+    {
+        _recorder->WriteText(type, text, x, y);
+    }
+}
+
+void IRender::NotifyInput(const InputEvent& event)
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        return;
+    }
+
+    _metrics.OnInput();
+    if (_tracer)
+    {
+        _tracer->OnInput(event);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_recorder_mutex);
+        if (_recorder)
+        {
+            _recorder->WriteInput(event);
+        }
+    }
+
+    if (_frame_rate && _frame_rate->OnInput())
+    {
+        _browser.value()->GetHost()->SetWindowlessFrameRate(_frame_rate->Rate());
+    }
+}
+
+void IRender::_UpdateFrameRate()
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        return;
+    }
+
+    uint32_t rate = _frame_rate->Rate();
+    if (_frame_rate->Update() != rate)
+    {
+        _browser.value()->GetHost()->SetWindowlessFrameRate(_frame_rate->Rate());
+    }
+
+    // the task holds a reference to the browser, which is released at the
+    // first tick after the close, when the task stops posting itself.
+    CefPostDelayedTask(TID_UI,
+                       base::BindOnce(&IRender::_UpdateFrameRate, CefRefPtr<IRender>(this)),
+                       FRAME_RATE_WINDOW_MS);
+}
+
+void IRender::_ApplyResize()
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_resize_mutex);
+
+        _width = _resize_width;
+        _height = _resize_height;
+        _is_resize_pending = false;
+        _resize_time = std::chrono::steady_clock::now();
+    }
+
     _browser.value()->GetHost()->WasResized();
 }
 
+// called on the thread of the host whenever it pulls frames or tiles.
+void IRender::_NotifyPull()
+{
+    _last_pull.store(RenderMetrics::Now());
+    if (_is_auto_hidden.exchange(false))
+    {
+        CefPostTask(TID_UI, base::BindOnce(&IRender::_UpdateVisibility, CefRefPtr<IRender>(this)));
+    }
+}
+
+void IRender::_CheckAutoHide()
+{
+    uint32_t intervals = _settings->auto_hide_intervals;
+    if (intervals == 0 || _is_auto_hidden.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    // frames that nobody pulls are wasted work, a browser that keeps painting
+    // them is hidden until the host comes back for a frame.
+    uint64_t interval =
+        1000000000ull / std::max(_max_frame_rate.load(std::memory_order_relaxed), 1u);
+    uint64_t last_pull = _last_pull.load();
+    if (RenderMetrics::Now() - last_pull <= interval * intervals)
+    {
+        return;
+    }
+
+    _is_auto_hidden.store(true);
+
+    // a pull that came in after the check either saw the flag and shows the
+    // browser again, or is seen here.
+    if (_last_pull.load() != last_pull)
+    {
+        _is_auto_hidden.store(false);
+        return;
+    }
+
+    _UpdateVisibility();
+}
+
+void IRender::_UpdateVisibility()
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        return;
+    }
+
+    bool is_hidden = !_is_visible.load(std::memory_order_relaxed) ||
+        _is_auto_hidden.load(std::memory_order_relaxed);
+    if (is_hidden == _is_hidden)
+    {
+        return;
+    }
+
+    _is_hidden = is_hidden;
+    _browser.value()->GetHost()->WasHidden(is_hidden);
+
+    // the frame store still holds the last frame for the host, a whole new
+    // frame follows as soon as chromium paints again.
+    if (!is_hidden)
+    {
+        _browser.value()->GetHost()->Invalidate(PET_VIEW);
+    }
+}
+
+void IRender::_SendBeginFrame(uint64_t id)
+{
+    if (is_closed)
+    {
+        return;
+    }
+
+    if (!_browser.has_value())
+    {
+        return;
+    }
+
+    _frame_request = id;
+    _metrics.OnBeginFrame();
+    _browser.value()->GetHost()->SendExternalBeginFrame();
+}
+
+const Frame* IRender::AcquireFrame()
+{
+    if (is_closed)
+    {
+        return nullptr;
+    }
+
+    if (!_frame_store)
+    {
+        return nullptr;
+    }
+
+    _NotifyPull();
+    return _frame_store->Acquire();
+}
+
+void IRender::ReleaseFrame(const Frame* frame)
+{
+    if (_frame_store)
+    {
+        _frame_store->Release(frame);
+    }
+}
+
+const TileSet* IRender::AcquireTiles(uint64_t since)
+{
+    if (is_closed)
+    {
+        return nullptr;
+    }
+
+    if (!_tile_surface)
+    {
+        return nullptr;
+    }
+
+    _NotifyPull();
+    return _tile_surface->Acquire(since);
+}
+
+void IRender::ReleaseTiles(const TileSet* tiles)
+{
+    if (_tile_surface)
+    {
+        _tile_surface->Release(tiles);
+    }
+}
+
+bool IRender::GetChangeFilterStats(ChangeFilterStats* stats)
+{
+    if (!_change_filter)
+    {
+        return false;
+    }
+
+    _change_filter->GetStats(stats);
+    return true;
+}
+
+bool IRender::GetFrameRing(FrameRingInfo* info)
+{
+    return _frame_ring ? _frame_ring->GetInfo(info) : false;
+}
+
+int IRender::AddOutput(const Rect& crop, int scale, OutputCallback callback, void* ctx)
+{
+    return _outputs.Add(crop, scale, callback, ctx);
+}
+
+void IRender::RemoveOutput(int id)
+{
+    _outputs.Remove(id);
+}
+
 void IRender::IClose()
 {
     _browser = std::nullopt;
     is_closed = true;
+    StopRecording();
 }
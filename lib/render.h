@@ -9,9 +9,26 @@
 #define LIBWEBVIEW_RENDER_H
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <vector>
 
+#include "change_filter.h"
+#include "frame_converter.h"
+#include "frame_output.h"
+#include "frame_rate.h"
+#include "frame_ring.h"
+#include "frame_store.h"
 #include "include/cef_app.h"
+#include "input_event.h"
+#include "input_tracer.h"
+#include "popup_compositor.h"
+#include "recorder.h"
+#include "render_metrics.h"
+#include "tile_surface.h"
 #include "webview.h"
 
 class IRender : public CefRenderHandler
@@ -30,6 +47,8 @@ public:
                                               const CefRange& selected_range,
                                               const RectList& character_bounds);
     virtual void GetViewRect(CefRefPtr<CefBrowser> browser, CefRect& rect) override;
+    virtual void OnPopupShow(CefRefPtr<CefBrowser> browser, bool show) override;
+    virtual void OnPopupSize(CefRefPtr<CefBrowser> browser, const CefRect& rect) override;
     virtual void OnPaint(CefRefPtr<CefBrowser> browser,
                          PaintElementType type,
                          const RectList& dirtyRects,
@@ -39,17 +58,77 @@ public:
 
     void SetBrowser(CefRefPtr<CefBrowser> browser);
     void Resize(int width, int height);
+    const Frame* AcquireFrame();
+    void ReleaseFrame(const Frame* frame);
+    const TileSet* AcquireTiles(uint64_t since);
+    void ReleaseTiles(const TileSet* tiles);
+    bool GetChangeFilterStats(ChangeFilterStats* stats);
+    bool GetFrameRing(FrameRingInfo* info);
+    void SetFrameRate(uint32_t frame_rate);
+    uint32_t GetFrameInterval();
+    uint64_t RequestFrame();
+    void SetVisible(bool is_visible);
+    int AddOutput(const Rect& crop, int scale, OutputCallback callback, void* ctx);
+    void RemoveOutput(int id);
+    void GetRenderStats(RenderStats* stats, bool reset);
+    bool StartRecording(const char* path, bool with_frames);
+    void StopRecording();
+    void NotifyInput(const InputEvent& event);
+    void NotifyInputText(InputTextType type, const std::string& text, int x, int y);
     void IClose();
 
 private:
+    void _DeliverFrame(const void* buffer, int width, int height);
+    void _UpdateFrameRate();
+    void _SendBeginFrame(uint64_t id);
+    void _ApplyResize();
+    void _NotifyPull();
+    void _CheckAutoHide();
+    void _UpdateVisibility();
+
     std::optional<CefRefPtr<CefBrowser>> _browser = std::nullopt;
 
-    bool is_closed = false;
+    std::atomic<bool> is_closed = false;
     BrowserSettings* _settings;
     BrowserObserver _observer;
     void* _ctx;
+    // the view size reported to chromium, only touched on the UI thread.
     int _width;
     int _height;
+    // the latest size given to |Resize| that is not applied yet.
+    std::mutex _resize_mutex;
+    int _resize_width = 0;
+    int _resize_height = 0;
+    bool _is_resize_pending = false;
+    std::chrono::steady_clock::time_point _resize_time;
+    std::atomic<uint32_t> _max_frame_rate;
+    std::vector<Rect> _dirty_rects;
+    PopupCompositor _popup;
+    FrameOutputs _outputs;
+    std::unique_ptr<FrameStore> _frame_store = nullptr;
+    std::unique_ptr<FrameRing> _frame_ring = nullptr;
+    std::unique_ptr<TileSurface> _tile_surface = nullptr;
+    std::unique_ptr<FrameRateController> _frame_rate = nullptr;
+    // ids handed out by |RequestFrame|, and the latest one sent to chromium.
+    std::atomic<uint64_t> _request_id = 0;
+    uint64_t _frame_request = 0;
+    // the visibility asked for by the host, and whether the auto hide policy
+    // hid the browser. |_is_hidden| is what chromium was told, only touched on
+    // the UI thread.
+    std::atomic<bool> _is_visible = true;
+    std::atomic<bool> _is_auto_hidden = false;
+    bool _is_hidden = false;
+    // when the host last pulled a frame or tiles.
+    std::atomic<uint64_t> _last_pull;
+    // the stamp of the paint being delivered.
+    FrameStamp _stamp = {};
+    RenderMetrics _metrics;
+    // started and stopped from any thread, written from the UI thread.
+    std::mutex _recorder_mutex;
+    std::unique_ptr<Recorder> _recorder = nullptr;
+    std::unique_ptr<ChangeFilter> _change_filter = nullptr;
+    std::unique_ptr<FrameConverter> _converter = nullptr;
+    std::unique_ptr<InputTracer> _tracer = nullptr;
 
     IMPLEMENT_REFCOUNTING(IRender);
 };
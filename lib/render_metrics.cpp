@@ -0,0 +1,105 @@
+//
+//  render_metrics.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/29.
+//
+
+#include "render_metrics.h"
+
+#include <chrono>
+
+static inline uint64_t load_counter(std::atomic<uint64_t>& counter, bool reset)
+{
+    return reset ? counter.exchange(0, std::memory_order_relaxed)
+                 : counter.load(std::memory_order_relaxed);
+}
+
+static inline void start_measurement(std::atomic<uint64_t>& start)
+{
+    uint64_t none = 0;
+    start.compare_exchange_strong(none, RenderMetrics::Now(), std::memory_order_relaxed);
+}
+
+static inline void end_measurement(std::atomic<uint64_t>& start, Histogram& histogram, uint64_t now)
+{
+    uint64_t time = start.exchange(0, std::memory_order_relaxed);
+    if (time != 0 && now >= time)
+    {
+        histogram.Record(now - time);
+    }
+}
+
+uint64_t RenderMetrics::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+FrameStamp RenderMetrics::OnPaint(uint64_t request_id)
+{
+    uint64_t now = Now();
+    if (_last_paint != 0)
+    {
+        _paint_interval.Record(now - _last_paint);
+    }
+
+    _last_paint = now;
+    _painted.fetch_add(1, std::memory_order_relaxed);
+    return FrameStamp{ ++_sequence, now, request_id, 0, 0 };
+}
+
+void RenderMetrics::OnFiltered()
+{
+    _filtered.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RenderMetrics::OnDelivered(const std::vector<Rect>& rects)
+{
+    uint64_t area = 0;
+    for (auto& rect : rects)
+    {
+        area += (uint64_t)rect.width * rect.height;
+    }
+
+    _dirty_area.Record(area);
+    _delivered.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t now = Now();
+    end_measurement(_input_time, _input_latency, now);
+    end_measurement(_begin_frame_time, _begin_frame_latency, now);
+}
+
+void RenderMetrics::OnCallback(uint64_t duration)
+{
+    _callback_duration.Record(duration);
+}
+
+void RenderMetrics::OnDropped()
+{
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RenderMetrics::OnInput()
+{
+    start_measurement(_input_time);
+}
+
+void RenderMetrics::OnBeginFrame()
+{
+    start_measurement(_begin_frame_time);
+}
+
+void RenderMetrics::GetStats(RenderStats* stats, bool reset)
+{
+    stats->painted = load_counter(_painted, reset);
+    stats->delivered = load_counter(_delivered, reset);
+    stats->filtered = load_counter(_filtered, reset);
+    stats->dropped = load_counter(_dropped, reset);
+    _paint_interval.Snapshot(&stats->paint_interval, reset);
+    _dirty_area.Snapshot(&stats->dirty_area, reset);
+    _callback_duration.Snapshot(&stats->callback_duration, reset);
+    _input_latency.Snapshot(&stats->input_latency, reset);
+    _begin_frame_latency.Snapshot(&stats->begin_frame_latency, reset);
+}
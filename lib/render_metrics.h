@@ -0,0 +1,66 @@
+//
+//  render_metrics.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/29.
+//
+
+#ifndef LIBWEBVIEW_RENDER_METRICS_H
+#define LIBWEBVIEW_RENDER_METRICS_H
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "frame.h"
+#include "histogram.h"
+#include "webview.h"
+
+//
+// Stamps the painted frames and measures the render path. The paint and
+// delivery hooks run on the CEF UI thread, inputs and begin frames can be
+// reported from any thread and the stats can be read from any thread.
+//
+class RenderMetrics
+{
+public:
+    // the monotonic clock frames are stamped with, in nanoseconds.
+    static uint64_t Now();
+
+    //
+    // Stamp a new paint with the next sequence number and the capture time.
+    //
+    FrameStamp OnPaint(uint64_t request_id);
+    void OnFiltered();
+    void OnDelivered(const std::vector<Rect>& rects);
+    void OnCallback(uint64_t duration);
+    void OnDropped();
+
+    //
+    // Start a latency measurement that the next delivered frame ends, a
+    // measurement that is already running is kept.
+    //
+    void OnInput();
+    void OnBeginFrame();
+
+    void GetStats(RenderStats* stats, bool reset);
+
+private:
+    // only touched on the CEF UI thread.
+    uint64_t _sequence = 0;
+    uint64_t _last_paint = 0;
+
+    std::atomic<uint64_t> _input_time = 0;
+    std::atomic<uint64_t> _begin_frame_time = 0;
+    std::atomic<uint64_t> _painted = 0;
+    std::atomic<uint64_t> _delivered = 0;
+    std::atomic<uint64_t> _filtered = 0;
+    std::atomic<uint64_t> _dropped = 0;
+    Histogram _paint_interval;
+    Histogram _dirty_area;
+    Histogram _callback_duration;
+    Histogram _input_latency;
+    Histogram _begin_frame_latency;
+};
+
+#endif  // LIBWEBVIEW_RENDER_METRICS_H
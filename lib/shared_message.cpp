@@ -0,0 +1,77 @@
+//
+//  shared_message.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/4.
+//
+
+#include "shared_message.h"
+
+#include <string.h>
+
+#include "include/cef_shared_process_message_builder.h"
+
+CefRefPtr<CefProcessMessage> SharedMessage::Create(const std::string& name,
+                                                   int seq_id,
+                                                   bool is_err,
+                                                   const void* data,
+                                                   size_t size)
+{
+    if (size < SHARED_MESSAGE_THRESHOLD)
+    {
+        return nullptr;
+    }
+
+    size_t region_size = sizeof(SharedMessageHeader) + size;
+    auto builder = CefSharedProcessMessageBuilder::Create(name, region_size);
+    if (!builder || !builder->IsValid())
+    {
+        return nullptr;
+    }
+
+    SharedMessageHeader header = { seq_id, is_err, size };
+    uint8_t* memory = (uint8_t*)builder->Memory();
+    memcpy(memory, &header, sizeof(header));
+    memcpy(memory + sizeof(header), data, size);
+    return builder->Build();
+}
+
+bool SharedMessage::Read(CefRefPtr<CefProcessMessage> msg)
+{
+    CefRefPtr<CefSharedMemoryRegion> region = msg->GetSharedMemoryRegion();
+    if (!region || !region->IsValid() || region->Size() < sizeof(SharedMessageHeader))
+    {
+        return false;
+    }
+
+    const uint8_t* memory = (const uint8_t*)region->Memory();
+    memcpy(&_header, memory, sizeof(_header));
+    if (_header.size > region->Size() - sizeof(SharedMessageHeader))
+    {
+        return false;
+    }
+
+    _region = region;
+    _data = memory + sizeof(SharedMessageHeader);
+    return true;
+}
+
+int SharedMessage::SeqId()
+{
+    return _header.seq_id;
+}
+
+bool SharedMessage::IsErr()
+{
+    return _header.is_err != 0;
+}
+
+std::string SharedMessage::String()
+{
+    return std::string((const char*)_data, _header.size);
+}
+
+std::vector<uint8_t> SharedMessage::Bytes()
+{
+    return std::vector<uint8_t>(_data, _data + _header.size);
+}
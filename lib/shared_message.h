@@ -0,0 +1,66 @@
+//
+//  shared_message.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/10/4.
+//
+
+#ifndef LIBWEBVIEW_SHARED_MESSAGE_H
+#define LIBWEBVIEW_SHARED_MESSAGE_H
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "include/cef_app.h"
+
+// payloads from this size on are sent through shared memory, smaller ones are
+// cheaper to copy into the argument list.
+#define SHARED_MESSAGE_THRESHOLD (64 * 1024)
+
+typedef struct
+{
+    int32_t seq_id;
+    int32_t is_err;
+    uint64_t size;
+} SharedMessageHeader;
+
+//
+// A process message that carries its payload in a shared memory region
+// instead of an argument list, so that only a handle crosses the process
+// boundary. The region starts with a SharedMessageHeader, which holds the
+// fields that would otherwise be arguments, followed by the payload.
+//
+class SharedMessage
+{
+public:
+    //
+    // Build a message with the payload written into shared memory, nullptr if
+    // the payload is below SHARED_MESSAGE_THRESHOLD or the region can not be
+    // created. The caller then falls back to an argument list.
+    //
+    static CefRefPtr<CefProcessMessage> Create(const std::string& name,
+                                               int seq_id,
+                                               bool is_err,
+                                               const void* data,
+                                               size_t size);
+
+    //
+    // Returns false if |msg| does not carry a valid shared memory region.
+    //
+    bool Read(CefRefPtr<CefProcessMessage> msg);
+
+    int SeqId();
+    bool IsErr();
+    std::string String();
+    std::vector<uint8_t> Bytes();
+
+private:
+    CefRefPtr<CefSharedMemoryRegion> _region = nullptr;
+    SharedMessageHeader _header = {};
+    const uint8_t* _data = nullptr;
+};
+
+#endif  // LIBWEBVIEW_SHARED_MESSAGE_H
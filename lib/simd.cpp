@@ -0,0 +1,701 @@
+//
+//  simd.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/20.
+//
+
+#include "simd.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+typedef struct
+{
+    const char* target;
+    bool (*equal)(const uint8_t* a, const uint8_t* b, size_t size);
+    void (*swap_rb)(const uint8_t* src, uint8_t* dst, size_t count);
+    void (*unpremultiply)(uint8_t* pixels, size_t count);
+    void (*blend)(const uint8_t* src, uint8_t* dst, size_t count);
+    void (*bgra_to_yuv)(const uint8_t* src,
+                        size_t src_stride,
+                        int width,
+                        int height,
+                        uint8_t* y,
+                        size_t y_stride,
+                        uint8_t* u,
+                        uint8_t* v,
+                        size_t uv_stride,
+                        size_t uv_step);
+    void (*downscale)(const uint8_t* src,
+                      size_t src_stride,
+                      int width,
+                      int height,
+                      uint8_t* dst,
+                      size_t dst_stride,
+                      int factor);
+} Kernels;
+
+/* =================== scalar ================= */
+
+static bool equal_scalar(const uint8_t* a, const uint8_t* b, size_t size)
+{
+    return size == 0 || memcmp(a, b, size) == 0;
+}
+
+static void swap_rb_scalar(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t b = src[i * 4];
+        dst[i * 4] = src[i * 4 + 2];
+        dst[i * 4 + 1] = src[i * 4 + 1];
+        dst[i * 4 + 2] = b;
+        dst[i * 4 + 3] = src[i * 4 + 3];
+    }
+}
+
+// 16.16 fixed point reciprocals of the alpha values, for unpremultiplying.
+static const struct UnpremultiplyTable
+{
+    uint32_t values[256];
+
+    UnpremultiplyTable()
+    {
+        values[0] = 0;
+        for (uint32_t a = 1; a < 256; a++)
+        {
+            values[a] = (255 * 65536 + a / 2) / a;
+        }
+    }
+} UNPREMULTIPLY_TABLE;
+
+static void unpremultiply_scalar(uint8_t* pixels, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t* pixel = pixels + i * 4;
+        uint8_t alpha = pixel[3];
+        if (alpha == 255)
+        {
+            continue;
+        }
+
+        uint32_t scale = UNPREMULTIPLY_TABLE.values[alpha];
+        for (int c = 0; c < 3; c++)
+        {
+            uint32_t value = (pixel[c] * scale + 32768) >> 16;
+            pixel[c] = value > 255 ? 255 : (uint8_t)value;
+        }
+    }
+}
+
+static void blend_scalar(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t inv_alpha = 255 - src[i * 4 + 3];
+        for (int c = 0; c < 4; c++)
+        {
+            // x / 255 rounded, without the division.
+            uint32_t x = dst[i * 4 + c] * inv_alpha + 128;
+            uint32_t value = src[i * 4 + c] + ((x + (x >> 8)) >> 8);
+            dst[i * 4 + c] = value > 255 ? 255 : (uint8_t)value;
+        }
+    }
+}
+
+static inline uint8_t yuv_y(int b, int g, int r)
+{
+    return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+static inline uint8_t yuv_u(int b, int g, int r)
+{
+    return (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+static inline uint8_t yuv_v(int b, int g, int r)
+{
+    return (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+static void bgra_to_yuv_scalar(const uint8_t* src,
+                               size_t src_stride,
+                               int width,
+                               int height,
+                               uint8_t* y,
+                               size_t y_stride,
+                               uint8_t* u,
+                               uint8_t* v,
+                               size_t uv_stride,
+                               size_t uv_step)
+{
+    for (int row = 0; row < height; row += 2)
+    {
+        bool has_next = row + 1 < height;
+        const uint8_t* s0 = src + row * src_stride;
+        const uint8_t* s1 = has_next ? s0 + src_stride : s0;
+        uint8_t* y0 = y + row * y_stride;
+        uint8_t* y1 = has_next ? y0 + y_stride : y0;
+        uint8_t* u_row = u + (row / 2) * uv_stride;
+        uint8_t* v_row = v + (row / 2) * uv_stride;
+
+        for (int col = 0; col < width; col += 2)
+        {
+            int next = col + 1 < width ? col + 1 : col;
+            const uint8_t* p[4] = { s0 + col * 4, s0 + next * 4, s1 + col * 4, s1 + next * 4 };
+
+            y0[col] = yuv_y(p[0][0], p[0][1], p[0][2]);
+            y0[next] = yuv_y(p[1][0], p[1][1], p[1][2]);
+            y1[col] = yuv_y(p[2][0], p[2][1], p[2][2]);
+            y1[next] = yuv_y(p[3][0], p[3][1], p[3][2]);
+
+            int b = (p[0][0] + p[1][0] + p[2][0] + p[3][0] + 2) >> 2;
+            int g = (p[0][1] + p[1][1] + p[2][1] + p[3][1] + 2) >> 2;
+            int r = (p[0][2] + p[1][2] + p[2][2] + p[3][2] + 2) >> 2;
+            u_row[(col / 2) * uv_step] = yuv_u(b, g, r);
+            v_row[(col / 2) * uv_step] = yuv_v(b, g, r);
+        }
+    }
+}
+
+static void downscale_scalar(const uint8_t* src,
+                             size_t src_stride,
+                             int width,
+                             int height,
+                             uint8_t* dst,
+                             size_t dst_stride,
+                             int factor)
+{
+    int shift = factor == 4 ? 4 : 2;
+    for (int row = 0; row < height; row++)
+    {
+        const uint8_t* s = src + row * factor * src_stride;
+        uint8_t* d = dst + row * dst_stride;
+        for (int col = 0; col < width; col++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                int sum = 0;
+                for (int y = 0; y < factor; y++)
+                {
+                    for (int x = 0; x < factor; x++)
+                    {
+                        sum += s[y * src_stride + (col * factor + x) * 4 + c];
+                    }
+                }
+
+                d[col * 4 + c] = (uint8_t)((sum + (1 << (shift - 1))) >> shift);
+            }
+        }
+    }
+}
+
+/* =================== SSE2 ================= */
+
+#ifdef SIMD_X86
+
+static bool equal_sse2(const uint8_t* a, const uint8_t* b, size_t size)
+{
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        __m128i x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i)),
+                                   _mm_loadu_si128((const __m128i*)(b + i)));
+        __m128i x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i + 16)),
+                                   _mm_loadu_si128((const __m128i*)(b + i + 16)));
+        __m128i x2 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i + 32)),
+                                   _mm_loadu_si128((const __m128i*)(b + i + 32)));
+        __m128i x3 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i + 48)),
+                                   _mm_loadu_si128((const __m128i*)(b + i + 48)));
+        __m128i x = _mm_or_si128(_mm_or_si128(x0, x1), _mm_or_si128(x2, x3));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) != 0xFFFF)
+        {
+            return false;
+        }
+    }
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i)),
+                                  _mm_loadu_si128((const __m128i*)(b + i)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) != 0xFFFF)
+        {
+            return false;
+        }
+    }
+
+    return equal_scalar(a + i, b + i, size - i);
+}
+
+static void swap_rb_sse2(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m128i ag_mask = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i rb_mask = _mm_set1_epi32(0x00FF00FF);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i * 4));
+        __m128i rb = _mm_and_si128(x, rb_mask);
+        __m128i br = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_and_si128(x, ag_mask), br));
+    }
+
+    swap_rb_scalar(src + i * 4, dst + i * 4, count - i);
+}
+
+static void unpremultiply_sse2(uint8_t* pixels, size_t count)
+{
+    const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(pixels + i * 4));
+        __m128i alpha = _mm_and_si128(x, alpha_mask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask)) != 0xFFFF)
+        {
+            unpremultiply_scalar(pixels + i * 4, 4);
+        }
+    }
+
+    unpremultiply_scalar(pixels + i * 4, count - i);
+}
+
+static inline __m128i blend_half_sse2(__m128i src, __m128i dst)
+{
+    // broadcast 255 - alpha of each pixel to its four 16 bit lanes.
+    __m128i inv_alpha = _mm_sub_epi16(_mm_set1_epi16(255), _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)));
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(dst, inv_alpha), _mm_set1_epi16(128));
+    x = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    return _mm_add_epi16(src, x);
+}
+
+static void blend_sse2(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i * 4));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), alpha_mask)) == 0xFFFF)
+        {
+            _mm_storeu_si128((__m128i*)(dst + i * 4), s);
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+        __m128i lo = blend_half_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = blend_half_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+
+    blend_scalar(src + i * 4, dst + i * 4, count - i);
+}
+
+// Split 8 BGRA pixels into 16 bit B, G and R lanes.
+static inline void unpack_bgr_sse2(const uint8_t* src, __m128i& b, __m128i& g, __m128i& r)
+{
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i p0 = _mm_loadu_si128((const __m128i*)src);
+    __m128i p1 = _mm_loadu_si128((const __m128i*)(src + 16));
+
+    b = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+    g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+                        _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+    r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+                        _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+}
+
+// The sums stay below 65536, so the 16 bit lanes are treated as unsigned.
+static inline __m128i luma_sse2(__m128i b, __m128i g, __m128i r)
+{
+    __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)),
+                              _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+    y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(25)));
+    y = _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(128)), 8);
+    return _mm_packus_epi16(_mm_add_epi16(y, _mm_set1_epi16(16)), _mm_setzero_si128());
+}
+
+// The sums stay within [-32768, 32767], so the 16 bit lanes are signed.
+static inline __m128i chroma_sse2(__m128i b, __m128i g, __m128i r, short cb, short cg, short cr)
+{
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)),
+                              _mm_mullo_epi16(g, _mm_set1_epi16(cg)));
+    x = _mm_add_epi16(x, _mm_mullo_epi16(b, _mm_set1_epi16(cb)));
+    x = _mm_srai_epi16(_mm_add_epi16(x, _mm_set1_epi16(128)), 8);
+    return _mm_packus_epi16(_mm_add_epi16(x, _mm_set1_epi16(128)), _mm_setzero_si128());
+}
+
+// Average the 2x2 blocks of two rows of 8 pixels into 4 samples.
+static inline __m128i average_sse2(__m128i row0, __m128i row1)
+{
+    __m128i sum = _mm_madd_epi16(_mm_add_epi16(row0, row1), _mm_set1_epi16(1));
+    sum = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(2)), 2);
+    return _mm_packs_epi32(sum, sum);
+}
+
+static void bgra_to_yuv_sse2(const uint8_t* src,
+                             size_t src_stride,
+                             int width,
+                             int height,
+                             uint8_t* y,
+                             size_t y_stride,
+                             uint8_t* u,
+                             uint8_t* v,
+                             size_t uv_stride,
+                             size_t uv_step)
+{
+    int row = 0;
+    for (; row + 2 <= height; row += 2)
+    {
+        const uint8_t* s0 = src + row * src_stride;
+        const uint8_t* s1 = s0 + src_stride;
+        uint8_t* y0 = y + row * y_stride;
+        uint8_t* y1 = y0 + y_stride;
+        uint8_t* u_row = u + (row / 2) * uv_stride;
+        uint8_t* v_row = v + (row / 2) * uv_stride;
+
+        int col = 0;
+        for (; col + 8 <= width; col += 8)
+        {
+            __m128i b0, g0, r0, b1, g1, r1;
+            unpack_bgr_sse2(s0 + col * 4, b0, g0, r0);
+            unpack_bgr_sse2(s1 + col * 4, b1, g1, r1);
+            _mm_storel_epi64((__m128i*)(y0 + col), luma_sse2(b0, g0, r0));
+            _mm_storel_epi64((__m128i*)(y1 + col), luma_sse2(b1, g1, r1));
+
+            __m128i b = average_sse2(b0, b1);
+            __m128i g = average_sse2(g0, g1);
+            __m128i r = average_sse2(r0, r1);
+            __m128i cu = chroma_sse2(b, g, r, 112, -74, -38);
+            __m128i cv = chroma_sse2(b, g, r, -18, -94, 112);
+
+            if (uv_step == 2)
+            {
+                _mm_storel_epi64((__m128i*)(u_row + col), _mm_unpacklo_epi8(cu, cv));
+            }
+            else
+            {
+                int32_t samples = _mm_cvtsi128_si32(cu);
+                memcpy(u_row + col / 2, &samples, 4);
+                samples = _mm_cvtsi128_si32(cv);
+                memcpy(v_row + col / 2, &samples, 4);
+            }
+        }
+
+        if (col < width)
+        {
+            bgra_to_yuv_scalar(s0 + col * 4, src_stride, width - col, 2, y0 + col, y_stride,
+                               u_row + (col / 2) * uv_step, v_row + (col / 2) * uv_step,
+                               uv_stride, uv_step);
+        }
+    }
+
+    if (row < height)
+    {
+        bgra_to_yuv_scalar(src + row * src_stride, src_stride, width, 1, y + row * y_stride,
+                           y_stride, u + (row / 2) * uv_stride, v + (row / 2) * uv_stride,
+                           uv_stride, uv_step);
+    }
+}
+
+// Sum the pixels of two rows of 4 pixels per channel, the two pixel pairs end
+// up in the low and high half of the 16 bit lanes.
+static inline __m128i sum_columns_sse2(__m128i row0, __m128i row1, __m128i& hi)
+{
+    const __m128i zero = _mm_setzero_si128();
+    hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+    return _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+}
+
+// Add the high half of the 16 bit lanes onto the low half.
+static inline __m128i fold_sse2(__m128i x)
+{
+    return _mm_add_epi16(x, _mm_srli_si128(x, 8));
+}
+
+static void downscale_sse2(const uint8_t* src,
+                           size_t src_stride,
+                           int width,
+                           int height,
+                           uint8_t* dst,
+                           size_t dst_stride,
+                           int factor)
+{
+    for (int row = 0; row < height; row++)
+    {
+        const uint8_t* s = src + row * factor * src_stride;
+        uint8_t* d = dst + row * dst_stride;
+
+        int col = 0;
+        if (factor == 2)
+        {
+            const __m128i round = _mm_set1_epi16(2);
+            for (; col + 4 <= width; col += 4)
+            {
+                __m128i ret[2];
+                for (int half = 0; half < 2; half++)
+                {
+                    const uint8_t* p = s + (col * 2 + half * 4) * 4;
+                    __m128i hi;
+                    __m128i lo = sum_columns_sse2(_mm_loadu_si128((const __m128i*)p),
+                                                  _mm_loadu_si128((const __m128i*)(p + src_stride)),
+                                                  hi);
+                    __m128i x = _mm_unpacklo_epi64(fold_sse2(lo), fold_sse2(hi));
+                    ret[half] = _mm_srli_epi16(_mm_add_epi16(x, round), 2);
+                }
+
+                _mm_storeu_si128((__m128i*)(d + col * 4), _mm_packus_epi16(ret[0], ret[1]));
+            }
+        }
+        else
+        {
+            const __m128i round = _mm_set1_epi16(8);
+            for (; col + 2 <= width; col += 2)
+            {
+                __m128i ret[2];
+                for (int half = 0; half < 2; half++)
+                {
+                    const uint8_t* p = s + (col * 4 + half * 4) * 4;
+                    __m128i hi0, hi1;
+                    __m128i lo0 = sum_columns_sse2(_mm_loadu_si128((const __m128i*)p),
+                                                   _mm_loadu_si128((const __m128i*)(p + src_stride)),
+                                                   hi0);
+                    __m128i lo1 = sum_columns_sse2(
+                        _mm_loadu_si128((const __m128i*)(p + src_stride * 2)),
+                        _mm_loadu_si128((const __m128i*)(p + src_stride * 3)),
+                        hi1);
+                    __m128i x = _mm_add_epi16(_mm_add_epi16(lo0, hi0), _mm_add_epi16(lo1, hi1));
+                    ret[half] = fold_sse2(x);
+                }
+
+                __m128i x = _mm_add_epi16(_mm_unpacklo_epi64(ret[0], ret[1]), round);
+                x = _mm_srli_epi16(x, 4);
+                _mm_storel_epi64((__m128i*)(d + col * 4), _mm_packus_epi16(x, x));
+            }
+        }
+
+        if (col < width)
+        {
+            downscale_scalar(s + col * factor * 4, src_stride, width - col, 1, d + col * 4,
+                             dst_stride, factor);
+        }
+    }
+}
+
+/* =================== AVX2 ================= */
+
+SIMD_TARGET_AVX2 static bool equal_avx2(const uint8_t* a, const uint8_t* b, size_t size)
+{
+    size_t i = 0;
+    for (; i + 128 <= size; i += 128)
+    {
+        __m256i x0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i)));
+        __m256i x1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i + 32)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i + 32)));
+        __m256i x2 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i + 64)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i + 64)));
+        __m256i x3 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i + 96)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i + 96)));
+        __m256i x = _mm256_or_si256(_mm256_or_si256(x0, x1), _mm256_or_si256(x2, x3));
+        if (!_mm256_testz_si256(x, x))
+        {
+            return false;
+        }
+    }
+
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                     _mm256_loadu_si256((const __m256i*)(b + i)));
+        if (!_mm256_testz_si256(x, x))
+        {
+            return false;
+        }
+    }
+
+    return equal_scalar(a + i, b + i, size - i);
+}
+
+SIMD_TARGET_AVX2 static void swap_rb_avx2(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_shuffle_epi8(x, shuffle));
+    }
+
+    swap_rb_scalar(src + i * 4, dst + i * 4, count - i);
+}
+
+SIMD_TARGET_AVX2 static void unpremultiply_avx2(uint8_t* pixels, size_t count)
+{
+    const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(pixels + i * 4));
+        __m256i alpha = _mm256_and_si256(x, alpha_mask);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alpha_mask)) != -1)
+        {
+            unpremultiply_scalar(pixels + i * 4, 8);
+        }
+    }
+
+    unpremultiply_scalar(pixels + i * 4, count - i);
+}
+
+SIMD_TARGET_AVX2 static void blend_avx2(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+    const __m256i alpha_shuffle = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15,
+                                                   14, 15, 6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14,
+                                                   15, 14, 15, 14, 15);
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, alpha_mask), alpha_mask)) ==
+            -1)
+        {
+            _mm256_storeu_si256((__m256i*)(dst + i * 4), s);
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+        __m256i ret[2];
+        for (int half = 0; half < 2; half++)
+        {
+            __m256i s16 = half ? _mm256_unpackhi_epi8(s, zero) : _mm256_unpacklo_epi8(s, zero);
+            __m256i d16 = half ? _mm256_unpackhi_epi8(d, zero) : _mm256_unpacklo_epi8(d, zero);
+            __m256i inv_alpha =
+                _mm256_sub_epi16(_mm256_set1_epi16(255), _mm256_shuffle_epi8(s16, alpha_shuffle));
+            __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(d16, inv_alpha), _mm256_set1_epi16(128));
+            x = _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+            ret[half] = _mm256_add_epi16(s16, x);
+        }
+
+        // unpack and pack both work per 128 bit lane, so the order is preserved.
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(ret[0], ret[1]));
+    }
+
+    blend_scalar(src + i * 4, dst + i * 4, count - i);
+}
+
+static bool has_avx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+
+    // the os has to save the ymm registers on context switches as well.
+    bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    if (!has_osxsave || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif  // SIMD_X86
+
+static Kernels select_kernels()
+{
+#ifdef SIMD_X86
+    if (has_avx2())
+    {
+        return Kernels{ "avx2", equal_avx2, swap_rb_avx2, unpremultiply_avx2, blend_avx2,
+                        bgra_to_yuv_sse2, downscale_sse2 };
+    }
+
+    return Kernels{ "sse2", equal_sse2, swap_rb_sse2, unpremultiply_sse2, blend_sse2,
+                    bgra_to_yuv_sse2, downscale_sse2 };
+#else
+    return Kernels{ "scalar", equal_scalar, swap_rb_scalar, unpremultiply_scalar, blend_scalar,
+                    bgra_to_yuv_scalar, downscale_scalar };
+#endif
+}
+
+static const Kernels KERNELS = select_kernels();
+
+bool SimdEqual(const uint8_t* a, const uint8_t* b, size_t size)
+{
+    return KERNELS.equal(a, b, size);
+}
+
+void SimdSwapRB(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    KERNELS.swap_rb(src, dst, count);
+}
+
+void SimdUnpremultiply(uint8_t* pixels, size_t count)
+{
+    KERNELS.unpremultiply(pixels, count);
+}
+
+void SimdBlend(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    KERNELS.blend(src, dst, count);
+}
+
+void SimdBgraToYuv(const uint8_t* src,
+                   size_t src_stride,
+                   int width,
+                   int height,
+                   uint8_t* y,
+                   size_t y_stride,
+                   uint8_t* u,
+                   uint8_t* v,
+                   size_t uv_stride,
+                   size_t uv_step)
+{
+    KERNELS.bgra_to_yuv(src, src_stride, width, height, y, y_stride, u, v, uv_stride, uv_step);
+}
+
+void SimdDownscale(const uint8_t* src,
+                   size_t src_stride,
+                   int width,
+                   int height,
+                   uint8_t* dst,
+                   size_t dst_stride,
+                   int factor)
+{
+    KERNELS.downscale(src, src_stride, width, height, dst, dst_stride, factor);
+}
+
+const char* SimdTarget()
+{
+    return KERNELS.target;
+}
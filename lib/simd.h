@@ -0,0 +1,79 @@
+//
+//  simd.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/20.
+//
+
+#ifndef LIBWEBVIEW_SIMD_H
+#define LIBWEBVIEW_SIMD_H
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Pixel kernels used by the render path. The best implementation for the
+// running cpu (AVX2, SSE2 or plain scalar code) is picked once at startup, so
+// callers never have to care about the instruction set.
+//
+
+//
+// Returns true if the first |size| bytes of |a| and |b| are identical.
+//
+bool SimdEqual(const uint8_t* a, const uint8_t* b, size_t size);
+
+//
+// Swap the first and third byte of |count| 32 bit pixels, this converts BGRA to
+// RGBA and back. |src| and |dst| may point to the same buffer.
+//
+void SimdSwapRB(const uint8_t* src, uint8_t* dst, size_t count);
+
+//
+// Convert |count| premultiplied alpha pixels to straight alpha in place, alpha
+// is the fourth byte of every pixel. Runs of opaque pixels are skipped.
+//
+void SimdUnpremultiply(uint8_t* pixels, size_t count);
+
+//
+// Blend |count| premultiplied alpha pixels of |src| over |dst| (source over),
+// opaque runs of |src| are copied as they are.
+//
+void SimdBlend(const uint8_t* src, uint8_t* dst, size_t count);
+
+//
+// Convert a |width| x |height| BGRA region into BT.601 limited range YUV 4:2:0.
+// Every 2x2 block of pixels shares one U and V sample, the samples of a row are
+// |uv_step| bytes apart, 1 for I420 planes and 2 for the interleaved NV12 plane.
+// Odd sizes reuse the last column or row for the incomplete blocks.
+//
+void SimdBgraToYuv(const uint8_t* src,
+                   size_t src_stride,
+                   int width,
+                   int height,
+                   uint8_t* y,
+                   size_t y_stride,
+                   uint8_t* u,
+                   uint8_t* v,
+                   size_t uv_stride,
+                   size_t uv_step);
+
+//
+// Downscale a region of BGRA pixels by |factor| (2 or 4) with a box filter, every
+// |factor| x |factor| block of |src| becomes one pixel of the |width| x |height|
+// region of |dst|.
+//
+void SimdDownscale(const uint8_t* src,
+                   size_t src_stride,
+                   int width,
+                   int height,
+                   uint8_t* dst,
+                   size_t dst_stride,
+                   int factor);
+
+//
+// Name of the instruction set the kernels were dispatched to, for logging.
+//
+const char* SimdTarget();
+
+#endif  // LIBWEBVIEW_SIMD_H
@@ -0,0 +1,241 @@
+//
+//  tile_surface.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/27.
+//
+
+#include "tile_surface.h"
+
+static inline uint64_t hash_mix(uint64_t hash, uint64_t value)
+{
+    hash ^= value * 0x9E3779B97F4A7C15ull;
+    hash = (hash << 31) | (hash >> 33);
+    return hash * 0xC2B2AE3D27D4EB4Full;
+}
+
+// Four independent lanes keep the multiplies of neighbouring words from
+// waiting on each other, |size| is a multiple of 4.
+static uint64_t hash_pixels(const uint8_t* data, size_t size)
+{
+    uint64_t lanes[4] = { 1, 2, 3, 4 };
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            uint64_t value;
+            memcpy(&value, data + i + lane * 8, 8);
+            lanes[lane] = hash_mix(lanes[lane], value);
+        }
+    }
+
+    uint64_t hash = size;
+    for (int lane = 0; lane < 4; lane++)
+    {
+        hash = hash_mix(hash, lanes[lane]);
+    }
+
+    for (; i + 4 <= size; i += 4)
+    {
+        uint32_t value;
+        memcpy(&value, data + i, 4);
+        hash = hash_mix(hash, value);
+    }
+
+    return hash ^ (hash >> 29);
+}
+
+void TileSurface::Write(const void* buffer, int width, int height, const std::vector<Rect>& rects)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    bool is_resized = width != _width || height != _height;
+    if (is_resized)
+    {
+        _Resize(width, height);
+        std::fill(_dirty.begin(), _dirty.end(), true);
+    }
+    else
+    {
+        for (auto& rect : rects)
+        {
+            Rect clip = RectIntersect(rect, Rect{ 0, 0, width, height });
+            if (RectIsEmpty(clip))
+            {
+                continue;
+            }
+
+            for (int row = clip.y / TILE_SIZE; row <= (clip.y + clip.height - 1) / TILE_SIZE; row++)
+            {
+                for (int col = clip.x / TILE_SIZE; col <= (clip.x + clip.width - 1) / TILE_SIZE;
+                     col++)
+                {
+                    _dirty[(size_t)row * _columns + col] = true;
+                }
+            }
+        }
+    }
+
+    const uint8_t* src = (const uint8_t*)buffer;
+    size_t stride = (size_t)width * FRAME_PIXEL_SIZE;
+    uint64_t version = _version + 1;
+    bool is_changed = false;
+
+    // the dirty rects decide what changed, the hash is only a hint for the
+    // host, two different tiles can have the same hash.
+    for (size_t i = 0; i < _states.size(); i++)
+    {
+        if (!_dirty[i])
+        {
+            continue;
+        }
+
+        _dirty[i] = false;
+
+        Rect rect = _TileRect(i);
+        size_t row_size = (size_t)rect.width * FRAME_PIXEL_SIZE;
+        const uint8_t* s = src + (size_t)rect.y * stride + (size_t)rect.x * FRAME_PIXEL_SIZE;
+
+        TileBuffer& tile = *_states[i].buffer;
+        std::lock_guard<std::mutex> tile_lock(tile.mutex);
+        for (int row = 0; row < rect.height; row++)
+        {
+            memcpy(tile.pixels + row * row_size, s + row * stride, row_size);
+        }
+
+        tile.hash = hash_pixels(tile.pixels, row_size * rect.height);
+        tile.version = version;
+        _states[i].version = version;
+        is_changed = true;
+    }
+
+    if (is_changed)
+    {
+        _version = version;
+    }
+}
+
+const TileSet* TileSurface::Acquire(uint64_t since)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_is_acquired)
+        {
+            return nullptr;
+        }
+
+        // a version the surface never had can not be trusted, start over.
+        if (since > _version)
+        {
+            since = 0;
+        }
+
+        _copies.clear();
+        for (size_t i = 0; i < _states.size(); i++)
+        {
+            if (_states[i].version > since)
+            {
+                _copies.push_back(TileCopy{ _TileRect(i), _states[i].buffer });
+            }
+        }
+
+        if (_copies.empty())
+        {
+            return nullptr;
+        }
+
+        _set.version = _version;
+        _set.width = _width;
+        _set.height = _height;
+        _is_acquired = true;
+    }
+
+    // a tile painted again since it was picked is copied with its newer
+    // version, which is above the version of the set, so the next acquire
+    // returns it once more.
+    _tiles.clear();
+    FrameBufferResize(_snapshot, _copies.size() * TILE_BYTES);
+    for (auto& copy : _copies)
+    {
+        uint8_t* dst = _snapshot.data() + _tiles.size() * TILE_BYTES;
+
+        Tile tile;
+        tile.x = copy.rect.x;
+        tile.y = copy.rect.y;
+        tile.width = copy.rect.width;
+        tile.height = copy.rect.height;
+        tile.buf = dst;
+
+        {
+            std::lock_guard<std::mutex> lock(copy.buffer->mutex);
+            memcpy(dst, copy.buffer->pixels,
+                   (size_t)copy.rect.width * copy.rect.height * FRAME_PIXEL_SIZE);
+            tile.version = copy.buffer->version;
+            tile.hash = copy.buffer->hash;
+        }
+
+        _tiles.push_back(tile);
+    }
+
+    // the buffers can be reused by the next resize.
+    _copies.clear();
+
+    _set.tiles = _tiles.data();
+    _set.tiles_size = _tiles.size();
+    return &_set;
+}
+
+void TileSurface::Release(const TileSet* tiles)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    assert(tiles == &_set);
+    _is_acquired = false;
+}
+
+void TileSurface::_Resize(int width, int height)
+{
+    _width = width;
+    _height = height;
+    _columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+    _rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    // the buffers an acquire still copies from are left to it, the tile
+    // they belong to is gone.
+    std::vector<std::shared_ptr<TileBuffer>> buffers;
+    for (auto& state : _states)
+    {
+        if (state.buffer.use_count() == 1)
+        {
+            buffers.push_back(std::move(state.buffer));
+        }
+    }
+
+    size_t count = (size_t)_columns * _rows;
+    _states.resize(count);
+    for (auto& state : _states)
+    {
+        state.version = 0;
+        if (!buffers.empty())
+        {
+            state.buffer = std::move(buffers.back());
+            buffers.pop_back();
+        }
+        else
+        {
+            state.buffer = std::make_shared<TileBuffer>();
+        }
+    }
+
+    _dirty.assign(count, false);
+}
+
+Rect TileSurface::_TileRect(size_t index)
+{
+    int x = (int)(index % _columns) * TILE_SIZE;
+    int y = (int)(index / _columns) * TILE_SIZE;
+    return Rect{ x, y, std::min(TILE_SIZE, _width - x), std::min(TILE_SIZE, _height - y) };
+}
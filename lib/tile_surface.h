@@ -0,0 +1,92 @@
+//
+//  tile_surface.h
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/27.
+//
+
+#ifndef LIBWEBVIEW_TILE_SURFACE_H
+#define LIBWEBVIEW_TILE_SURFACE_H
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "frame.h"
+#include "webview.h"
+
+//
+// Keeps the view as a grid of TILE_SIZE x TILE_SIZE tiles. Every paint copies
+// the tiles under the dirty rects, gives them the new surface version and
+// hashes them, so the host can skip uploading a tile whose hash it already
+// has. The host asks for the tiles newer than the version it has seen and
+// gets a copy of just those tiles.
+//
+// Every tile has its own buffer and lock. The surface lock only guards the
+// grid, the copy for the host is made outside of it, so a paint waits for at
+// most the copy of one tile.
+//
+class TileSurface
+{
+public:
+    //
+    // Update the tiles under |rects| from a BGRA frame. Only called on the CEF
+    // UI thread.
+    //
+    void Write(const void* buffer, int width, int height, const std::vector<Rect>& rects);
+
+    //
+    // Take the tiles that changed after version |since|, returns null if no
+    // tile changed or the previous set was not released yet. The set stays
+    // valid until it is released.
+    //
+    const TileSet* Acquire(uint64_t since);
+    void Release(const TileSet* tiles);
+
+private:
+    static constexpr size_t TILE_BYTES = TILE_SIZE * TILE_SIZE * FRAME_PIXEL_SIZE;
+
+    typedef struct
+    {
+        std::mutex mutex;
+        uint64_t version;
+        uint64_t hash;
+        // the pixels without row padding.
+        uint8_t pixels[TILE_BYTES];
+    } TileBuffer;
+
+    typedef struct
+    {
+        uint64_t version;
+        // shared with an acquire that is copying the tile.
+        std::shared_ptr<TileBuffer> buffer;
+    } TileState;
+
+    typedef struct
+    {
+        Rect rect;
+        std::shared_ptr<TileBuffer> buffer;
+    } TileCopy;
+
+    void _Resize(int width, int height);
+    Rect _TileRect(size_t index);
+
+    std::mutex _mutex;
+    int _width = 0;
+    int _height = 0;
+    int _columns = 0;
+    int _rows = 0;
+    uint64_t _version = 0;
+    std::vector<TileState> _states;
+    std::vector<bool> _dirty;
+    // the set handed to the consumer and the copy of its tiles, only touched
+    // by the acquire that set |_is_acquired|.
+    bool _is_acquired = false;
+    std::vector<TileCopy> _copies;
+    TileSet _set = {};
+    std::vector<Tile> _tiles;
+    std::vector<uint8_t> _snapshot;
+};
+
+#endif  // LIBWEBVIEW_TILE_SURFACE_H
@@ -168,6 +168,35 @@ void browser_send_touch(Browser* browser,
     browser->ref->OnTouch(id, x, y, (cef_touch_event_type_t)type, (cef_pointer_type_t)pointer_type);
 }
 
+size_t browser_send_input_batch(Browser* browser, const InputEvent* events, size_t count)
+{
+    assert(browser);
+
+    return browser->ref->OnInputBatch(events, count);
+}
+
+void browser_send_text(Browser* browser, const char* text, size_t size)
+{
+    assert(browser);
+
+    browser->ref->OnText(text, size);
+}
+
+void browser_get_input_stats(Browser* browser, InputStats* stats, bool reset)
+{
+    assert(browser);
+    assert(stats);
+
+    browser->ref->GetInputStats(stats, reset);
+}
+
+void browser_sync_keyboard_state(Browser* browser)
+{
+    assert(browser);
+
+    browser->ref->SyncKeyboardState();
+}
+
 void browser_bridge_call(Browser* browser, char* req, BridgeCallCallback callback, void* ctx)
 {
     assert(browser);
@@ -177,6 +206,18 @@ void browser_bridge_call(Browser* browser, char* req, BridgeCallCallback callbac
     browser->ref->BridgeCall(req, callback, ctx);
 }
 
+void browser_bridge_call_binary(Browser* browser,
+                                const uint8_t* req,
+                                size_t size,
+                                BridgeBinaryCallCallback callback,
+                                void* ctx)
+{
+    assert(browser);
+    assert(callback);
+
+    browser->ref->BridgeCallBinary(req, size, callback, ctx);
+}
+
 void browser_set_devtools_state(Browser* browser, bool is_open)
 {
     assert(browser);
@@ -191,6 +232,27 @@ void browser_resize(Browser* browser, int width, int height)
     browser->ref->Resize(width, height);
 }
 
+void browser_set_frame_rate(Browser* browser, uint32_t frame_rate)
+{
+    assert(browser);
+
+    browser->ref->SetFrameRate(frame_rate);
+}
+
+void browser_set_visible(Browser* browser, bool is_visible)
+{
+    assert(browser);
+
+    browser->ref->SetVisible(is_visible);
+}
+
+uint64_t browser_request_frame(Browser* browser)
+{
+    assert(browser);
+
+    return browser->ref->RequestFrame();
+}
+
 const void* browser_get_hwnd(Browser* browser)
 {
     assert(browser);
@@ -214,3 +276,121 @@ void browser_send_ime_set_composition(Browser* browser, char* input, int x, int
 
     browser->ref->OnIMESetComposition(std::string(input), x, y);
 }
+
+const Frame* browser_acquire_frame(Browser* browser)
+{
+    assert(browser);
+
+    return browser->ref->AcquireFrame();
+}
+
+void browser_release_frame(Browser* browser, const Frame* frame)
+{
+    assert(browser);
+    assert(frame);
+
+    browser->ref->ReleaseFrame(frame);
+}
+
+bool browser_get_change_filter_stats(Browser* browser, ChangeFilterStats* stats)
+{
+    assert(browser);
+    assert(stats);
+
+    return browser->ref->GetChangeFilterStats(stats);
+}
+
+const TileSet* browser_acquire_tiles(Browser* browser, uint64_t since)
+{
+    assert(browser);
+
+    return browser->ref->AcquireTiles(since);
+}
+
+void browser_release_tiles(Browser* browser, const TileSet* tiles)
+{
+    assert(browser);
+    assert(tiles);
+
+    browser->ref->ReleaseTiles(tiles);
+}
+
+bool browser_get_frame_ring(Browser* browser, FrameRingInfo* info)
+{
+    assert(browser);
+    assert(info);
+
+    return browser->ref->GetFrameRing(info);
+}
+
+int browser_add_output(Browser* browser,
+                       Rect crop,
+                       int scale,
+                       OutputCallback callback,
+                       void* ctx)
+{
+    assert(browser);
+    assert(callback);
+
+    return browser->ref->AddOutput(crop, scale, callback, ctx);
+}
+
+void browser_remove_output(Browser* browser, int id)
+{
+    assert(browser);
+
+    browser->ref->RemoveOutput(id);
+}
+
+void browser_get_render_stats(Browser* browser, RenderStats* stats, bool reset)
+{
+    assert(browser);
+    assert(stats);
+
+    browser->ref->GetRenderStats(stats, reset);
+}
+
+bool browser_start_recording(Browser* browser, const char* path)
+{
+    assert(browser);
+    assert(path);
+
+    return browser->ref->StartRecording(path, true);
+}
+
+bool browser_start_input_recording(Browser* browser, const char* path)
+{
+    assert(browser);
+    assert(path);
+
+    return browser->ref->StartRecording(path, false);
+}
+
+void browser_stop_recording(Browser* browser)
+{
+    assert(browser);
+
+    browser->ref->StopRecording();
+}
+
+bool browser_start_replay(Browser* browser, const char* path, bool is_realtime)
+{
+    assert(browser);
+    assert(path);
+
+    return browser->ref->StartReplay(path, is_realtime);
+}
+
+void browser_stop_replay(Browser* browser)
+{
+    assert(browser);
+
+    browser->ref->StopReplay();
+}
+
+bool browser_is_replaying(Browser* browser)
+{
+    assert(browser);
+
+    return browser->ref->IsReplaying();
+}
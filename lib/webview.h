@@ -16,6 +16,7 @@
 #endif
 
 #include "include/cef_app.h"
+#include "input_event.h"
 
 class IApp;
 class IBrowser;
@@ -33,6 +34,25 @@ typedef struct
     CefRefPtr<IApp> ref;
 } App;
 
+typedef enum
+{
+    // 32 bits per pixel, this is what chromium paints.
+    kBGRA = 0,
+    kRGBA = 1,
+    // 8 bit Y plane followed by the U and V planes at half resolution.
+    kI420 = 2,
+    // 8 bit Y plane followed by an interleaved UV plane at half resolution.
+    kNV12 = 3,
+} PixelFormat;
+
+typedef enum
+{
+    kKeyboardLayoutUS = 0,
+    kKeyboardLayoutUK = 1,
+    kKeyboardLayoutDE = 2,
+    kKeyboardLayoutFR = 3,
+} KeyboardLayout;
+
 typedef struct
 {
     char* url;
@@ -42,6 +62,47 @@ typedef struct
     uint32_t height;
     float device_scale_factor;
     bool is_offscreen;
+    // Keep painted frames in a triple buffered store instead of calling
+    // |on_frame|, the host pulls them with |browser_acquire_frame|.
+    bool frame_store;
+    // Compare the dirty regions of every paint against the previous frame and
+    // drop the frames where no pixel changed.
+    bool change_filter;
+    // Pixel format of the delivered frames, only the dirty regions are
+    // converted on every paint.
+    PixelFormat output_format;
+    // Chromium paints premultiplied alpha, convert BGRA/RGBA frames to
+    // straight alpha.
+    bool straight_alpha;
+    // Number of slots of the shared memory frame ring, 0 disables the ring.
+    // See |browser_get_frame_ring|.
+    uint32_t frame_ring_slots;
+    // Lower the frame rate while the page is static or the consumer falls
+    // behind, and raise it again on paint activity or input. |frame_rate|
+    // becomes the upper bound of the rate.
+    bool adaptive_frame_rate;
+    // Chromium only produces a frame when the host asks for one with
+    // |browser_request_frame|, instead of on its own timer.
+    bool external_begin_frame;
+    // Keep the view as a surface of TILE_SIZE x TILE_SIZE tiles instead of
+    // calling |on_frame|, the host pulls the changed tiles with
+    // |browser_acquire_tiles|.
+    bool tiled_output;
+    // Hide the browser when the host has not pulled a frame or tiles for this
+    // many frame intervals, so that chromium stops rendering it. The next
+    // pull shows it again, 0 disables the policy. Only used together with
+    // |frame_store| or |tiled_output|.
+    uint32_t auto_hide_intervals;
+    // Merge consecutive mouse moves and sum consecutive wheel deltas over a
+    // frame interval. The first event of an interval is sent right away, any
+    // other input event sends the held back one first.
+    bool coalesce_input;
+    // Layout that scan codes are translated with to key codes and typed
+    // characters.
+    KeyboardLayout keyboard_layout;
+    // Stamp the input events and follow each one to the first paint that
+    // shows it, see |RenderStats::input_to_paint| and |Frame::input_id|.
+    bool trace_input;
 } BrowserSettings;
 
 typedef struct
@@ -105,19 +166,226 @@ typedef struct
     int height;
 } Rect;
 
+typedef struct
+{
+    const void* buf;
+    size_t size;
+    PixelFormat format;
+    int width;
+    int height;
+    const Rect* rects;
+    size_t rects_size;
+    // id of the latest |browser_request_frame| issued before the frame was
+    // painted, 0 if the external begin frame mode is not enabled.
+    uint64_t request_id;
+    // number of the paint the frame comes from, starting at 1. Paints that
+    // are not delivered leave gaps.
+    uint64_t sequence;
+    // when the paint arrived from chromium, monotonic clock in nanoseconds
+    // (CLOCK_MONOTONIC on linux).
+    uint64_t timestamp;
+    // id of the oldest input event that the frame is the first to show, 0 if
+    // there is none or |trace_input| is not enabled. Ids count the forwarded
+    // input events from 1.
+    uint64_t input_id;
+    // when that input event was forwarded to chromium, same clock as
+    // |timestamp|.
+    uint64_t input_timestamp;
+} Frame;
+
+#define TILE_SIZE 64
+
+typedef struct
+{
+    // position and size of the tile in pixels of the view, the tiles on the
+    // right and bottom edge can be smaller than TILE_SIZE.
+    int x;
+    int y;
+    int width;
+    int height;
+    // version of the surface when the tile was last painted.
+    uint64_t version;
+    // 64 bit hash of the tile pixels, a tile with the hash of the content the
+    // host already has is almost certainly unchanged and can be skipped.
+    uint64_t hash;
+    // |width * height| BGRA pixels without row padding.
+    const void* buf;
+} Tile;
+
+typedef struct
+{
+    // version of the surface, pass it to the next |browser_acquire_tiles| to
+    // get the tiles that changed after this set.
+    uint64_t version;
+    int width;
+    int height;
+    const Tile* tiles;
+    size_t tiles_size;
+} TileSet;
+
+typedef struct
+{
+    // frames painted by chromium.
+    uint64_t frames;
+    // frames dropped because none of their pixels changed.
+    uint64_t dropped_frames;
+    // dirty rects removed because none of their pixels changed.
+    uint64_t dropped_rects;
+} ChangeFilterStats;
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t mean;
+    // percentiles, within 1/16 of the true value.
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+} HistogramStats;
+
+typedef struct
+{
+    // paints received from chromium.
+    uint64_t painted;
+    // frames handed to the host.
+    uint64_t delivered;
+    // paints dropped by the change filter.
+    uint64_t filtered;
+    // frames replaced in the frame store before the host acquired them.
+    uint64_t dropped;
+    // nanoseconds between two paints.
+    HistogramStats paint_interval;
+    // pixels under the dirty rects of a delivered frame.
+    HistogramStats dirty_area;
+    // nanoseconds spent in |on_frame| or |on_frame_ex|.
+    HistogramStats callback_duration;
+    // nanoseconds from an input event to the next delivered frame.
+    HistogramStats input_latency;
+    // nanoseconds from a begin frame being sent to the next delivered frame.
+    HistogramStats begin_frame_latency;
+    // traced input events that no paint showed within a second, like moves
+    // over a static page, see |trace_input|.
+    uint64_t expired_inputs;
+    // nanoseconds from a traced input event to the first paint that shows it:
+    // a paint whose dirty rects contain the position of a click, move or
+    // touch, or the next paint for keys, wheels and text.
+    HistogramStats input_to_paint;
+    // nanoseconds from a traced input event to the delivery of that paint.
+    HistogramStats input_to_delivered;
+} RenderStats;
+
+typedef struct
+{
+    // input events, text and IME calls pushed into the input queue.
+    uint64_t queued;
+    // input dropped because the queue was full.
+    uint64_t dropped;
+    // nanoseconds input waited in the queue before the UI thread took it.
+    HistogramStats queue_delay;
+    // inputs taken from the queue by one task on the UI thread.
+    HistogramStats drain_size;
+} InputStats;
+
+//
+// Layout of the shared memory frame ring. The memory starts with a
+// FrameRingHeader followed by |slots| FrameRingSlot, the pixels of every slot
+// live at |offset| from the start of the memory.
+//
+#define FRAME_RING_MAGIC 0x52465657
+#define FRAME_RING_VERSION 1
+#define FRAME_RING_MAX_RECTS 16
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t reserved;
+    // size of the memory in bytes, the memory only ever grows, readers remap
+    // when it is larger than their mapping.
+    uint64_t size;
+    // sequence of the latest published frame, 0 until the first frame.
+    uint64_t sequence;
+} FrameRingHeader;
+
+typedef struct
+{
+    // odd while the slot is written, a reader has to see the same even value
+    // before and after reading the slot, otherwise the slot was overwritten.
+    uint64_t lock;
+    // frame |sequence| lives in slot |sequence % slots|.
+    uint64_t sequence;
+    // see |Frame::timestamp|.
+    uint64_t timestamp;
+    // see |Frame::request_id|.
+    uint64_t request_id;
+    uint64_t offset;
+    uint64_t size;
+    // PixelFormat of the pixels.
+    int32_t format;
+    int32_t width;
+    int32_t height;
+    // regions changed since frame |sequence - 1|.
+    uint32_t rects_size;
+    Rect rects[FRAME_RING_MAX_RECTS];
+} FrameRingSlot;
+
+typedef struct
+{
+    // memfd of the ring, map it read only with MAP_SHARED.
+    int fd;
+    // eventfd that is signaled after every published frame.
+    int event_fd;
+} FrameRingInfo;
+
 typedef void (*CreateAppCallback)(void* ctx);
 typedef void (*BridgeOnCallback)(void* cb_ctx, Result ret);
 typedef void (*BridgeOnHandler)(const char* req, void* ctx, void* cb_ctx, BridgeOnCallback cb);
 typedef void (*BridgeCallCallback)(const char* res, void* ctx);
+//
+// Binary bridge calls carry raw bytes end to end, JS sees them as ArrayBuffer.
+// With |is_err| the bytes are the UTF-8 error message.
+//
+typedef void (*BridgeBinaryOnCallback)(void* cb_ctx, const uint8_t* res, size_t size, bool is_err);
+typedef void (*BridgeOnBinaryHandler)(const uint8_t* req,
+                                      size_t size,
+                                      void* ctx,
+                                      void* cb_ctx,
+                                      BridgeBinaryOnCallback cb);
+typedef void (*BridgeBinaryCallCallback)(const uint8_t* res, size_t size, bool is_err, void* ctx);
+typedef void (*OutputCallback)(const Frame* frame, void* ctx);
 
 typedef struct
 {
     void (*on_state_change)(BrowserState state, void* ctx);
     void (*on_ime_rect)(Rect rect, void* ctx);
+    //
+    // |buf| is in the |output_format| of the settings, which is not always
+    // 4 bytes per pixel: I420 and NV12 frames are planar YUV.
+    //
     void (*on_frame)(const void* buf, int width, int height, void* ctx);
+    //
+    // Same as |on_frame|, but also carries the dirty rectangles of the frame,
+    // relative to the upper-left corner of the view. When set, it is called
+    // instead of |on_frame|.
+    //
+    void (*on_frame_ex)(const Frame* frame, void* ctx);
     void (*on_title_change)(const char* title, void* ctx);
     void (*on_fullscreen_change)(bool fullscreen, void* ctx);
     void (*on_bridge)(const char* req, void* ctx, void* cb_ctx, BridgeOnCallback cb);
+    //
+    // A |native.bridge.callBinary| from the page. The request is only valid
+    // during the call, |cb| can be called later from any thread and copies
+    // the response.
+    //
+    void (*on_bridge_binary)(const uint8_t* req,
+                             size_t size,
+                             void* ctx,
+                             void* cb_ctx,
+                             BridgeBinaryOnCallback cb);
 } BrowserObserver;
 
 extern "C" EXPORT void execute_sub_process(int argc, char** argv);
@@ -145,6 +413,13 @@ extern "C" EXPORT Browser * create_browser(App * app,
 
 extern "C" EXPORT void browser_exit(Browser * browser);
 
+//
+// The input functions below can be called from any number of threads at once.
+// They push the input into a bounded lock free queue of the browser, which a
+// task on the CEF UI thread drains in order. Input that does not fit into the
+// full queue is dropped, see |browser_get_input_stats|.
+//
+
 //
 // Send a mouse click event to the browser.
 //
@@ -195,19 +470,191 @@ extern "C" EXPORT void browser_send_touch(Browser * browser,
                                           TouchEventType type,
                                           TouchPointerType pointer_type);
 
+//
+// Send |count| input events to the browser in one call. The events are copied
+// into the input queue in order, clicks are always sent with their position.
+// Returns how many events were queued, if the queue fills up the remaining
+// events are not queued and can be sent again later.
+//
+extern "C" EXPORT size_t browser_send_input_batch(Browser * browser,
+                                                  const InputEvent* events,
+                                                  size_t count);
+
+//
+// Type |size| bytes of UTF-8 text into the focused element in one call. Runs
+// of text are committed like IME input, line breaks and tabs are sent as key
+// presses of Enter and Tab. The text is copied and queued as one entry, in
+// order with the other input.
+//
+extern "C" EXPORT void browser_send_text(Browser * browser, const char* text, size_t size);
+
+//
+// Get the counters and histograms of the input queue, with |reset| they start
+// over. Can be called from any thread.
+//
+extern "C" EXPORT void browser_get_input_stats(Browser * browser, InputStats * stats, bool reset);
+
+//
+// Take the caps lock and num lock state from the system. The browser keeps
+// the modifier and lock state from the key events it is sent, and only asks
+// the system when it is created and when this is called, for example after
+// the host window regains focus.
+//
+extern "C" EXPORT void browser_sync_keyboard_state(Browser * browser);
+
 extern "C" EXPORT void browser_bridge_call(Browser * browser,
                                            char* req,
                                            BridgeCallCallback callback,
                                            void* ctx);
 
+//
+// Call the |native.bridge.onBinary| handler of the page with |size| bytes, the
+// request is copied. |callback| gets the ArrayBuffer the page responds with,
+// it is only valid during the callback.
+//
+extern "C" EXPORT void browser_bridge_call_binary(Browser * browser,
+                                                  const uint8_t* req,
+                                                  size_t size,
+                                                  BridgeBinaryCallCallback callback,
+                                                  void* ctx);
+
 extern "C" EXPORT void browser_set_devtools_state(Browser * browser, bool is_open);
 
+//
+// Resize the view. Resizes are coalesced: the latest size is applied on the
+// CEF UI thread, at most once per frame interval.
+//
 extern "C" EXPORT void browser_resize(Browser * browser, int width, int height);
 
+//
+// Change the maximum rate at which frames are painted, in frames per second.
+// With |adaptive_frame_rate| enabled this is the upper bound of the rate.
+//
+extern "C" EXPORT void browser_set_frame_rate(Browser * browser, uint32_t frame_rate);
+
+//
+// Show or hide the browser, a hidden browser is not rendered at all. When it
+// is shown again the whole view is repainted and delivered.
+//
+extern "C" EXPORT void browser_set_visible(Browser * browser, bool is_visible);
+
+//
+// Ask chromium to produce a frame, only valid with |external_begin_frame|
+// enabled. Returns the id the resulting frame is tagged with, ids start at 1
+// and 0 is returned if the mode is not enabled. A request does not produce a
+// frame if nothing changed, and invalidations are only painted on the next
+// request.
+//
+extern "C" EXPORT uint64_t browser_request_frame(Browser * browser);
+
 extern "C" EXPORT const void* browser_get_hwnd(Browser * browser);
 
 extern "C" EXPORT void browser_send_ime_composition(Browser * browser, char* input);
 
 extern "C" EXPORT void browser_send_ime_set_composition(Browser * browser, char* input, int x, int y);
 
+//
+// Take the latest frame from the frame store, returns null if the frame store
+// is not enabled or there is no new frame since the last call. The dirty rects
+// of the frame cover everything that changed since the previously acquired
+// frame. The frame must be given back with |browser_release_frame| before the
+// next one can be acquired.
+//
+extern "C" EXPORT const Frame* browser_acquire_frame(Browser * browser);
+
+extern "C" EXPORT void browser_release_frame(Browser * browser, const Frame* frame);
+
+//
+// Get the counters of the change filter, returns false if the change filter is
+// not enabled.
+//
+extern "C" EXPORT bool browser_get_change_filter_stats(Browser * browser, ChangeFilterStats * stats);
+
+//
+// Take the tiles whose content changed after surface version |since|, pass 0
+// to get all tiles. Returns null if tiled output is not enabled, nothing
+// changed, or the previous set was not released yet. The set must be given
+// back with |browser_release_tiles| before the next one can be acquired.
+//
+extern "C" EXPORT const TileSet* browser_acquire_tiles(Browser * browser, uint64_t since);
+
+extern "C" EXPORT void browser_release_tiles(Browser * browser, const TileSet* tiles);
+
+//
+// Get the file descriptors of the shared memory frame ring, returns false if
+// the ring is not enabled or not supported on this platform. The descriptors
+// stay owned by the browser, pass them to the reading process over a unix
+// socket or by inheritance.
+//
+// The writer never waits for readers: frames are written to the slot after the
+// previous one and the oldest frame is overwritten. A reader that falls more
+// than |slots - 1| frames behind sees a gap in the sequence numbers, and has
+// to treat the next frame it reads as fully damaged.
+//
+extern "C" EXPORT bool browser_get_frame_ring(Browser * browser, FrameRingInfo * info);
+
+//
+// Add a derived output of the painted frames, a region of the view downscaled
+// by a box filter. |crop| is in pixels of the painted frame, an empty rect
+// takes the whole view, and |scale| is 1, 2 or 4. The output is kept between
+// frames and only the parts under the dirty rects are recomputed, |callback|
+// is called on the CEF UI thread with a BGRA frame whenever the output
+// changed. Returns the id of the output, or -1 if |scale| is not supported.
+//
+extern "C" EXPORT int browser_add_output(Browser * browser,
+                                         Rect crop,
+                                         int scale,
+                                         OutputCallback callback,
+                                         void* ctx);
+
+//
+// Remove a derived output, once this returns |callback| is not called anymore.
+// Must not be called from inside the callback.
+//
+extern "C" EXPORT void browser_remove_output(Browser * browser, int id);
+
+//
+// Get the counters and histograms of the render path, with |reset| they start
+// over so that every call covers the time since the previous one. Can be
+// called from any thread.
+//
+extern "C" EXPORT void browser_get_render_stats(Browser * browser, RenderStats * stats, bool reset);
+
+//
+// Start recording the painted frames and the input events into |path|, a
+// recording that is already running is stopped first. The recording is
+// written by a background thread, frames are dropped rather than holding up
+// painting when the disk can not keep up. Returns false if the file can not be
+// created. Use the webview-replay tool to inspect, replay and extract frames.
+//
+extern "C" EXPORT bool browser_start_recording(Browser * browser, const char* path);
+
+//
+// Start recording only the input into |path|: every mouse, keyboard, touch,
+// text and IME call with its timestamp. The log is compact and can be played
+// back with |browser_start_replay|. Stopped with |browser_stop_recording|.
+//
+extern "C" EXPORT bool browser_start_input_recording(Browser * browser, const char* path);
+
+//
+// Stop the recording, returns once every queued frame is written.
+//
+extern "C" EXPORT void browser_stop_recording(Browser * browser);
+
+//
+// Play back the input of a recording made with |browser_start_recording| or
+// |browser_start_input_recording| on a background thread. With |is_realtime|
+// the events keep their original timing, otherwise they are sent as fast as
+// possible in batches. A replay that is already running is stopped first.
+// Returns false if the file can not be read.
+//
+extern "C" EXPORT bool browser_start_replay(Browser * browser, const char* path, bool is_realtime);
+
+extern "C" EXPORT void browser_stop_replay(Browser * browser);
+
+//
+// Returns true until every event of the replay was sent.
+//
+extern "C" EXPORT bool browser_is_replaying(Browser * browser);
+
 #endif  // LIBWEBVIEW_WEBVIEW_H
@@ -15,6 +15,8 @@ use super::RawBrowser;
 use crate::ptr::{from_c_str, AsCStr};
 
 type BridgeCallCallback = extern "C" fn(res: *const c_char, ctx: *mut c_void);
+type BridgeBinaryCallCallback =
+    extern "C" fn(res: *const u8, size: usize, is_err: bool, ctx: *mut c_void);
 
 extern "C" {
     fn browser_bridge_call(
@@ -23,6 +25,13 @@ extern "C" {
         callback: BridgeCallCallback,
         ctx: *mut c_void,
     );
+    fn browser_bridge_call_binary(
+        browser: *const RawBrowser,
+        req: *const u8,
+        size: usize,
+        callback: BridgeBinaryCallCallback,
+        ctx: *mut c_void,
+    );
 }
 
 #[async_trait]
@@ -34,6 +43,15 @@ pub trait BridgeObserver: Send + Sync {
     async fn on(&self, req: Self::Req) -> Result<Self::Res, Self::Err>;
 }
 
+/// handles `native.bridge.callBinary` from the page, the bytes are passed
+/// through as they are, the page sees them as `ArrayBuffer`.
+#[async_trait]
+pub trait BinaryBridgeObserver: Send + Sync {
+    type Err: ToString;
+
+    async fn on(&self, req: Vec<u8>) -> Result<Vec<u8>, Self::Err>;
+}
+
 pub(crate) struct BridgeOnHandler<Q, S, E> {
     processor: Arc<dyn BridgeObserver<Req = Q, Res = S, Err = E>>,
 }
@@ -70,6 +88,11 @@ pub(crate) struct BridgeOnContext(
     pub Arc<dyn Fn(String, Box<dyn FnOnce(Result<String, String>) + Send + Sync>)>,
 );
 
+#[derive(Clone)]
+pub(crate) struct BridgeOnBinaryContext(
+    pub Arc<dyn Fn(Vec<u8>, Box<dyn FnOnce(Result<Vec<u8>, String>) + Send + Sync>)>,
+);
+
 #[derive(Debug)]
 pub enum BridgeError {
     SerdeError,
@@ -124,6 +147,48 @@ impl Bridge {
     }
 }
 
+impl Bridge {
+    pub(crate) async fn call_binary(
+        ptr: *const RawBrowser,
+        req: &[u8],
+    ) -> Result<Option<Vec<u8>>, BridgeError> {
+        let (tx, rx) = channel::<Option<Vec<u8>>>();
+        unsafe {
+            browser_bridge_call_binary(
+                ptr,
+                req.as_ptr(),
+                req.len(),
+                bridge_binary_call_callback,
+                Box::into_raw(Box::new(tx)) as *mut c_void,
+            );
+        }
+
+        timeout(Duration::from_secs(10), rx)
+            .await
+            .map_err(|_| BridgeError::Timeout)?
+            .map_err(|_| BridgeError::CallError)
+    }
+}
+
+extern "C" fn bridge_binary_call_callback(
+    res: *const u8,
+    size: usize,
+    is_err: bool,
+    ctx: *mut c_void,
+) {
+    let tx = unsafe { Box::from_raw(ctx as *mut Sender<Option<Vec<u8>>>) };
+    let res = if is_err {
+        None
+    } else if size == 0 {
+        Some(Vec::new())
+    } else {
+        Some(unsafe { std::slice::from_raw_parts(res, size) }.to_vec())
+    };
+
+    // the receiver is gone once the call timed out.
+    let _ = tx.send(res);
+}
+
 extern "C" fn bridge_call_callback(res: *const c_char, ctx: *mut c_void) {
     let tx = unsafe { Box::from_raw(ctx as *mut Sender<Option<String>>) };
     tx.send(from_c_str(res))
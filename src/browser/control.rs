@@ -50,12 +50,39 @@ pub enum TouchPointerType {
     Unknown = 4,
 }
 
+/// layout that scan codes are translated with to key codes and typed
+/// characters.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum KeyboardLayout {
+    US = 0,
+    UK = 1,
+    DE = 2,
+    FR = 3,
+}
+
+impl Default for KeyboardLayout {
+    fn default() -> Self {
+        Self::US
+    }
+}
+
 #[derive(Debug, Clone, Copy)]
 pub struct Position {
     pub x: i32,
     pub y: i32,
 }
 
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+struct RawInputEvent {
+    ty: c_int,
+    x: c_int,
+    y: c_int,
+    code: c_int,
+    flags: c_int,
+}
+
 extern "C" {
     fn browser_send_mouse_click(browser: *const RawBrowser, button: MouseButtons, pressed: bool);
     fn browser_send_mouse_click_with_pos(
@@ -81,6 +108,13 @@ extern "C" {
         kind: TouchEventType,
         pointer_type: TouchPointerType,
     );
+    fn browser_send_input_batch(
+        browser: *const RawBrowser,
+        events: *const RawInputEvent,
+        count: usize,
+    ) -> usize;
+    fn browser_send_text(browser: *const RawBrowser, text: *const c_char, size: usize);
+    fn browser_sync_keyboard_state(browser: *const RawBrowser);
     fn browser_send_ime_composition(browser: *const RawBrowser, input: *const c_char);
     fn browser_send_ime_set_composition(
         browser: *const RawBrowser,
@@ -109,6 +143,55 @@ pub enum MouseAction {
     Wheel(Position),
 }
 
+/// an input event of a batch, see `Browser::on_input_batch`.
+#[derive(Debug, Clone, Copy)]
+pub enum InputEvent {
+    MouseClick(MouseButtons, ActionState, Position),
+    MouseMove(Position),
+    MouseWheel(Position),
+    Keyboard(u32, ActionState, Modifiers),
+    Touch(i32, Position, TouchEventType, TouchPointerType),
+}
+
+impl From<&InputEvent> for RawInputEvent {
+    // same layout as the events that are recorded, see input_event.h.
+    fn from(event: &InputEvent) -> Self {
+        let (ty, x, y, code, flags) = match *event {
+            InputEvent::MouseClick(button, state, pos) => (
+                1,
+                pos.x,
+                pos.y,
+                button as c_int,
+                state.is_pressed() as c_int,
+            ),
+            InputEvent::MouseMove(pos) => (2, pos.x, pos.y, 0, 0),
+            InputEvent::MouseWheel(pos) => (3, pos.x, pos.y, 0, 0),
+            InputEvent::Keyboard(scan_code, state, modifiers) => (
+                4,
+                0,
+                0,
+                scan_code as c_int,
+                state.is_pressed() as c_int | (modifiers as c_int) << 1,
+            ),
+            InputEvent::Touch(id, pos, ty, pointer_type) => (
+                5,
+                pos.x,
+                pos.y,
+                id,
+                ty as c_int | (pointer_type as c_int) << 8,
+            ),
+        };
+
+        Self {
+            ty,
+            x,
+            y,
+            code,
+            flags,
+        }
+    }
+}
+
 #[derive(Debug)]
 pub enum ImeAction<'a> {
     Composition(&'a str),
@@ -149,6 +232,27 @@ impl Control {
         unsafe { browser_send_keyboard(ptr, scan_code as c_int, state.is_pressed(), modifiers) }
     }
 
+    pub fn on_input_batch(ptr: *const RawBrowser, events: &[InputEvent]) -> usize {
+        if events.is_empty() {
+            return 0;
+        }
+
+        let events = events.iter().map(RawInputEvent::from).collect::<Vec<_>>();
+        unsafe { browser_send_input_batch(ptr, events.as_ptr(), events.len()) }
+    }
+
+    pub fn on_text(ptr: *const RawBrowser, text: &str) {
+        if text.is_empty() {
+            return;
+        }
+
+        unsafe { browser_send_text(ptr, text.as_ptr() as *const c_char, text.len()) }
+    }
+
+    pub fn sync_keyboard_state(ptr: *const RawBrowser) {
+        unsafe { browser_sync_keyboard_state(ptr) }
+    }
+
     pub fn on_touch(
         ptr: *const RawBrowser,
         id: i32,
@@ -19,12 +19,16 @@ use tokio::{
 
 use crate::{
     app::RawApp,
-    ptr::{from_c_str, release_c_str, to_c_str, AsCStr},
-    ActionState, ImeAction, Modifiers, MouseAction, TouchEventType, TouchPointerType,
+    ptr::{from_c_str, release_c_str, to_c_str, AsCStr, CStrPtr},
+    ActionState, ImeAction, InputEvent, KeyboardLayout, Modifiers, MouseAction, TouchEventType,
+    TouchPointerType,
 };
 
 use self::{
-    bridge::{Bridge, BridgeError, BridgeObserver, BridgeOnContext, BridgeOnHandler},
+    bridge::{
+        BinaryBridgeObserver, Bridge, BridgeError, BridgeObserver, BridgeOnBinaryContext,
+        BridgeOnContext, BridgeOnHandler,
+    },
     control::{Control, Rect},
 };
 
@@ -45,6 +49,9 @@ struct Ret {
 }
 
 type BridgeOnCallback = extern "C" fn(callback_ctx: *mut c_void, ret: Ret);
+type BridgeBinaryOnCallback =
+    extern "C" fn(callback_ctx: *mut c_void, res: *const u8, size: usize, is_err: bool);
+type OutputCallback = extern "C" fn(frame: *const RawFrame, ctx: *mut c_void);
 
 #[repr(C)]
 #[derive(Clone, Copy)]
@@ -52,6 +59,7 @@ struct RawBrowserObserver {
     on_state_change: extern "C" fn(state: BrowserState, ctx: *mut c_void),
     on_ime_rect: extern "C" fn(rect: Rect, ctx: *mut c_void),
     on_frame: extern "C" fn(buf: *const c_void, width: c_int, height: c_int, ctx: *mut c_void),
+    on_frame_ex: extern "C" fn(frame: *const RawFrame, ctx: *mut c_void),
     on_title_change: extern "C" fn(title: *const c_char, ctx: *mut c_void),
     on_fullscreen_change: extern "C" fn(fullscreen: bool, ctx: *mut c_void),
     on_bridge: extern "C" fn(
@@ -60,6 +68,67 @@ struct RawBrowserObserver {
         callback_ctx: *mut c_void,
         callback: BridgeOnCallback,
     ),
+    on_bridge_binary: extern "C" fn(
+        req: *const u8,
+        size: usize,
+        ctx: *mut c_void,
+        callback_ctx: *mut c_void,
+        callback: BridgeBinaryOnCallback,
+    ),
+}
+
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PixelFormat {
+    /// 32 bits per pixel, this is what chromium paints.
+    BGRA = 0,
+    RGBA = 1,
+    /// 8 bit Y plane followed by the U and V planes at half resolution.
+    I420 = 2,
+    /// 8 bit Y plane followed by an interleaved UV plane at half resolution.
+    NV12 = 3,
+}
+
+impl Default for PixelFormat {
+    fn default() -> Self {
+        Self::BGRA
+    }
+}
+
+#[repr(C)]
+struct RawFrame {
+    buf: *const c_void,
+    size: usize,
+    format: PixelFormat,
+    width: c_int,
+    height: c_int,
+    rects: *const Rect,
+    rects_size: usize,
+    request_id: u64,
+    sequence: u64,
+    timestamp: u64,
+    input_id: u64,
+    input_timestamp: u64,
+}
+
+#[repr(C)]
+struct RawTile {
+    x: c_int,
+    y: c_int,
+    width: c_int,
+    height: c_int,
+    version: u64,
+    hash: u64,
+    buf: *const c_void,
+}
+
+#[repr(C)]
+struct RawTileSet {
+    version: u64,
+    width: c_int,
+    height: c_int,
+    tiles: *const RawTile,
+    tiles_size: usize,
 }
 
 #[repr(C)]
@@ -71,6 +140,18 @@ struct RawBrowserSettings {
     height: u32,
     device_scale_factor: c_float,
     is_offscreen: bool,
+    frame_store: bool,
+    change_filter: bool,
+    output_format: PixelFormat,
+    straight_alpha: bool,
+    frame_ring_slots: u32,
+    adaptive_frame_rate: bool,
+    external_begin_frame: bool,
+    tiled_output: bool,
+    auto_hide_intervals: u32,
+    coalesce_input: bool,
+    keyboard_layout: KeyboardLayout,
+    trace_input: bool,
 }
 
 impl Drop for RawBrowserSettings {
@@ -93,8 +174,40 @@ extern "C" {
     ) -> *const RawBrowser;
     fn browser_exit(browser: *const RawBrowser);
     fn browser_resize(browser: *const RawBrowser, width: c_int, height: c_int);
+    fn browser_set_frame_rate(browser: *const RawBrowser, frame_rate: u32);
+    fn browser_set_visible(browser: *const RawBrowser, is_visible: bool);
+    fn browser_request_frame(browser: *const RawBrowser) -> u64;
     fn browser_get_hwnd(browser: *const RawBrowser) -> *const c_void;
     fn browser_set_devtools_state(browser: *const RawBrowser, is_open: bool);
+    fn browser_acquire_frame(browser: *const RawBrowser) -> *const RawFrame;
+    fn browser_release_frame(browser: *const RawBrowser, frame: *const RawFrame);
+    fn browser_acquire_tiles(browser: *const RawBrowser, since: u64) -> *const RawTileSet;
+    fn browser_release_tiles(browser: *const RawBrowser, tiles: *const RawTileSet);
+    fn browser_get_change_filter_stats(
+        browser: *const RawBrowser,
+        stats: *mut ChangeFilterStats,
+    ) -> bool;
+    fn browser_get_frame_ring(browser: *const RawBrowser, info: *mut FrameRingInfo) -> bool;
+    fn browser_add_output(
+        browser: *const RawBrowser,
+        crop: Rect,
+        scale: c_int,
+        callback: OutputCallback,
+        ctx: *mut c_void,
+    ) -> c_int;
+    fn browser_remove_output(browser: *const RawBrowser, id: c_int);
+    fn browser_get_render_stats(browser: *const RawBrowser, stats: *mut RenderStats, reset: bool);
+    fn browser_get_input_stats(browser: *const RawBrowser, stats: *mut InputStats, reset: bool);
+    fn browser_start_recording(browser: *const RawBrowser, path: *const c_char) -> bool;
+    fn browser_start_input_recording(browser: *const RawBrowser, path: *const c_char) -> bool;
+    fn browser_stop_recording(browser: *const RawBrowser);
+    fn browser_start_replay(
+        browser: *const RawBrowser,
+        path: *const c_char,
+        is_realtime: bool,
+    ) -> bool;
+    fn browser_stop_replay(browser: *const RawBrowser);
+    fn browser_is_replaying(browser: *const RawBrowser) -> bool;
 }
 
 #[derive(Debug, Clone, Copy)]
@@ -128,6 +241,43 @@ pub struct BrowserSettings<'a> {
     pub height: u32,
     pub device_scale_factor: f32,
     pub is_offscreen: bool,
+    /// keep frames in a triple buffered store instead of calling
+    /// `Observer::on_frame`, frames are pulled with `Browser::acquire_frame`.
+    pub frame_store: bool,
+    /// drop frames whose dirty regions did not change any pixel.
+    pub change_filter: bool,
+    /// pixel format of the delivered frames.
+    pub output_format: PixelFormat,
+    /// chromium paints premultiplied alpha, convert BGRA/RGBA frames to
+    /// straight alpha.
+    pub straight_alpha: bool,
+    /// number of slots of the shared memory frame ring, 0 disables the ring,
+    /// see `Browser::frame_ring`.
+    pub frame_ring_slots: u32,
+    /// lower the frame rate while the page is static or the consumer falls
+    /// behind, and raise it again on paint activity or input, `frame_rate`
+    /// becomes the upper bound of the rate.
+    pub adaptive_frame_rate: bool,
+    /// chromium only produces a frame when the host asks for one with
+    /// `Browser::request_frame`, instead of on its own timer.
+    pub external_begin_frame: bool,
+    /// keep the view as a surface of `TILE_SIZE` x `TILE_SIZE` tiles instead
+    /// of calling `Observer::on_frame`, the changed tiles are pulled with
+    /// `Browser::acquire_tiles`.
+    pub tiled_output: bool,
+    /// hide the browser when the host has not pulled a frame or tiles for
+    /// this many frame intervals, the next pull shows it again. 0 disables
+    /// the policy, only used together with `frame_store` or `tiled_output`.
+    pub auto_hide_intervals: u32,
+    /// merge consecutive mouse moves and sum consecutive wheel deltas over a
+    /// frame interval, the first event of an interval is sent right away.
+    pub coalesce_input: bool,
+    /// layout that scan codes are translated with to key codes and typed
+    /// characters.
+    pub keyboard_layout: KeyboardLayout,
+    /// stamp the input events and follow each one to the first paint that
+    /// shows it, see `RenderStats::input_to_paint` and `Frame::input_id`.
+    pub trace_input: bool,
 }
 
 impl Into<RawBrowserSettings> for &BrowserSettings<'_> {
@@ -140,15 +290,318 @@ impl Into<RawBrowserSettings> for &BrowserSettings<'_> {
             height: self.height,
             device_scale_factor: self.device_scale_factor,
             is_offscreen: self.is_offscreen,
+            frame_store: self.frame_store,
+            change_filter: self.change_filter,
+            output_format: self.output_format,
+            straight_alpha: self.straight_alpha,
+            frame_ring_slots: self.frame_ring_slots,
+            adaptive_frame_rate: self.adaptive_frame_rate,
+            external_begin_frame: self.external_begin_frame,
+            tiled_output: self.tiled_output,
+            auto_hide_intervals: self.auto_hide_intervals,
+            coalesce_input: self.coalesce_input,
+            keyboard_layout: self.keyboard_layout,
+            trace_input: self.trace_input,
+        }
+    }
+}
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct ChangeFilterStats {
+    /// frames painted by chromium.
+    pub frames: u64,
+    /// frames dropped because none of their pixels changed.
+    pub dropped_frames: u64,
+    /// dirty rects removed because none of their pixels changed.
+    pub dropped_rects: u64,
+}
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct HistogramStats {
+    pub count: u64,
+    pub min: u64,
+    pub max: u64,
+    pub mean: u64,
+    /// percentiles, within 1/16 of the true value.
+    pub p50: u64,
+    pub p90: u64,
+    pub p99: u64,
+    pub p999: u64,
+}
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct RenderStats {
+    /// paints received from chromium.
+    pub painted: u64,
+    /// frames handed to the host.
+    pub delivered: u64,
+    /// paints dropped by the change filter.
+    pub filtered: u64,
+    /// frames replaced in the frame store before they were acquired.
+    pub dropped: u64,
+    /// nanoseconds between two paints.
+    pub paint_interval: HistogramStats,
+    /// pixels under the dirty rects of a delivered frame.
+    pub dirty_area: HistogramStats,
+    /// nanoseconds spent in `Observer::on_frame` or `Observer::on_frame_ex`.
+    pub callback_duration: HistogramStats,
+    /// nanoseconds from an input event to the next delivered frame.
+    pub input_latency: HistogramStats,
+    /// nanoseconds from a begin frame being sent to the next delivered frame.
+    pub begin_frame_latency: HistogramStats,
+    /// traced input events that no paint showed within a second, like moves
+    /// over a static page.
+    pub expired_inputs: u64,
+    /// nanoseconds from a traced input event to the first paint that shows
+    /// it: a paint whose dirty rects contain the position of a click, move or
+    /// touch, or the next paint for keys, wheels and text.
+    pub input_to_paint: HistogramStats,
+    /// nanoseconds from a traced input event to the delivery of that paint.
+    pub input_to_delivered: HistogramStats,
+}
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct InputStats {
+    /// input events, text and ime calls pushed into the input queue.
+    pub queued: u64,
+    /// input dropped because the queue was full.
+    pub dropped: u64,
+    /// nanoseconds input waited in the queue before the ui thread took it.
+    pub queue_delay: HistogramStats,
+    /// inputs taken from the queue by one task on the ui thread.
+    pub drain_size: HistogramStats,
+}
+
+pub const FRAME_RING_MAGIC: u32 = 0x52465657;
+pub const FRAME_RING_VERSION: u32 = 1;
+pub const FRAME_RING_MAX_RECTS: usize = 16;
+
+/// header at the start of the shared memory frame ring, followed by `slots`
+/// `FrameRingSlot`.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct FrameRingHeader {
+    pub magic: u32,
+    pub version: u32,
+    pub slots: u32,
+    pub reserved: u32,
+    /// size of the memory in bytes, the memory only ever grows, remap when it
+    /// is larger than the mapping.
+    pub size: u64,
+    /// sequence of the latest published frame, 0 until the first frame.
+    pub sequence: u64,
+}
+
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct FrameRingSlot {
+    /// odd while the slot is written, the same even value has to be seen
+    /// before and after reading the slot, otherwise it was overwritten.
+    pub lock: u64,
+    /// frame `sequence` lives in slot `sequence % slots`.
+    pub sequence: u64,
+    /// see `Frame::timestamp`.
+    pub timestamp: u64,
+    /// see `Frame::request_id`.
+    pub request_id: u64,
+    pub offset: u64,
+    pub size: u64,
+    /// `PixelFormat` of the pixels.
+    pub format: i32,
+    pub width: i32,
+    pub height: i32,
+    /// regions changed since frame `sequence - 1`.
+    pub rects_size: u32,
+    pub rects: [Rect; FRAME_RING_MAX_RECTS],
+}
+
+/// file descriptors of the shared memory frame ring, they stay owned by the
+/// browser.
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct FrameRingInfo {
+    /// memfd of the ring, map it read only and shared.
+    pub fd: c_int,
+    /// eventfd that is signaled after every published frame.
+    pub event_fd: c_int,
+}
+
+#[derive(Debug)]
+pub struct Frame<'a> {
+    pub texture: &'a [u8],
+    pub format: PixelFormat,
+    pub width: u32,
+    pub height: u32,
+    /// the regions of the texture that changed since the previous frame,
+    /// relative to the upper-left corner of the view.
+    pub dirty_rects: &'a [Rect],
+    /// id of the latest `Browser::request_frame` issued before the frame was
+    /// painted, 0 if the external begin frame mode is not enabled.
+    pub request_id: u64,
+    /// number of the paint the frame comes from, starting at 1. paints that
+    /// are not delivered leave gaps.
+    pub sequence: u64,
+    /// when the paint arrived from chromium, monotonic clock in nanoseconds
+    /// (CLOCK_MONOTONIC on linux).
+    pub timestamp: u64,
+    /// id of the oldest input event that the frame is the first to show, 0
+    /// if there is none or `BrowserSettings::trace_input` is not enabled. ids
+    /// count the forwarded input events from 1.
+    pub input_id: u64,
+    /// when that input event was forwarded to chromium, same clock as
+    /// `timestamp`.
+    pub input_timestamp: u64,
+}
+
+impl<'a> From<&'a RawFrame> for Frame<'a> {
+    fn from(frame: &'a RawFrame) -> Self {
+        Self {
+            texture: unsafe { from_raw_parts(frame.buf as *const _, frame.size) },
+            format: frame.format,
+            width: frame.width as u32,
+            height: frame.height as u32,
+            dirty_rects: if frame.rects.is_null() {
+                &[]
+            } else {
+                unsafe { from_raw_parts(frame.rects, frame.rects_size) }
+            },
+            request_id: frame.request_id,
+            sequence: frame.sequence,
+            timestamp: frame.timestamp,
+            input_id: frame.input_id,
+            input_timestamp: frame.input_timestamp,
         }
     }
 }
 
+/// a frame taken from the frame store, it is given back to the store when
+/// dropped.
+pub struct FrameGuard<'a> {
+    browser: &'a Browser,
+    ptr: *const RawFrame,
+}
+
+impl<'a> FrameGuard<'a> {
+    pub fn frame(&self) -> Frame<'_> {
+        Frame::from(unsafe { &*self.ptr })
+    }
+}
+
+impl Drop for FrameGuard<'_> {
+    fn drop(&mut self) {
+        unsafe { browser_release_frame(self.browser.ptr, self.ptr) }
+    }
+}
+
+pub const TILE_SIZE: u32 = 64;
+
+#[derive(Debug)]
+pub struct Tile<'a> {
+    /// position and size of the tile in pixels of the view, the tiles on the
+    /// right and bottom edge can be smaller than `TILE_SIZE`.
+    pub x: u32,
+    pub y: u32,
+    pub width: u32,
+    pub height: u32,
+    /// version of the surface when the tile was last painted.
+    pub version: u64,
+    /// hash of the pixels, a tile with the hash of the content already
+    /// uploaded is almost certainly unchanged and can be skipped.
+    pub hash: u64,
+    /// BGRA pixels without row padding.
+    pub texture: &'a [u8],
+}
+
+impl<'a> From<&'a RawTile> for Tile<'a> {
+    fn from(tile: &'a RawTile) -> Self {
+        Self {
+            x: tile.x as u32,
+            y: tile.y as u32,
+            width: tile.width as u32,
+            height: tile.height as u32,
+            version: tile.version,
+            hash: tile.hash,
+            texture: unsafe {
+                from_raw_parts(
+                    tile.buf as *const _,
+                    tile.width as usize * tile.height as usize * 4,
+                )
+            },
+        }
+    }
+}
+
+/// the tiles taken from the tile surface, they are given back to the surface
+/// when dropped.
+pub struct TileSetGuard<'a> {
+    browser: &'a Browser,
+    ptr: *const RawTileSet,
+}
+
+impl<'a> TileSetGuard<'a> {
+    /// version of the surface, pass it to the next `Browser::acquire_tiles`
+    /// to get the tiles that changed after this set.
+    pub fn version(&self) -> u64 {
+        unsafe { &*self.ptr }.version
+    }
+
+    pub fn size(&self) -> (u32, u32) {
+        let set = unsafe { &*self.ptr };
+        (set.width as u32, set.height as u32)
+    }
+
+    pub fn tiles(&self) -> impl Iterator<Item = Tile<'_>> {
+        let set = unsafe { &*self.ptr };
+        unsafe { from_raw_parts(set.tiles, set.tiles_size) }
+            .iter()
+            .map(Tile::from)
+    }
+}
+
+impl Drop for TileSetGuard<'_> {
+    fn drop(&mut self) {
+        unsafe { browser_release_tiles(self.browser.ptr, self.ptr) }
+    }
+}
+
+type OutputHandler = Box<dyn Fn(&Frame) + Send + Sync>;
+
+/// a derived output of the painted frames, see `Browser::add_output`. the
+/// output is removed when dropped.
+pub struct FrameOutput<'a> {
+    browser: &'a Browser,
+    id: c_int,
+    handler: *mut OutputHandler,
+}
+
+impl Drop for FrameOutput<'_> {
+    fn drop(&mut self) {
+        unsafe { browser_remove_output(self.browser.ptr, self.id) }
+        drop(unsafe { Box::from_raw(self.handler) });
+    }
+}
+
+extern "C" fn on_output(frame: *const RawFrame, ctx: *mut c_void) {
+    (unsafe { &*(ctx as *mut OutputHandler) })(&Frame::from(unsafe { &*frame }));
+}
+
 #[allow(unused)]
 pub trait Observer: Send + Sync {
     fn on_state_change(&self, state: BrowserState) {}
     fn on_ime_rect(&self, rect: Rect) {}
+    /// `texture` is in the `BrowserSettings::output_format`, which is planar
+    /// YUV for I420 and NV12 rather than 4 bytes per pixel.
     fn on_frame(&self, texture: &[u8], width: u32, height: u32) {}
+    /// same as `on_frame`, but also carries the dirty rects and the format,
+    /// the default implementation forwards the frame to `on_frame` whatever
+    /// the format is.
+    fn on_frame_ex(&self, frame: &Frame) {
+        self.on_frame(frame.texture, frame.width, frame.height)
+    }
     fn on_title_change(&self, title: String) {}
     fn on_fullscreen_change(&self, fullscreen: bool) {}
 }
@@ -162,6 +615,7 @@ struct Delegation {
     observer: Arc<dyn Observer>,
     tx: Arc<UnboundedSender<ChannelEvents>>,
     on_bridge_callback: Arc<RwLock<Option<BridgeOnContext>>>,
+    on_bridge_binary_callback: Arc<RwLock<Option<BridgeOnBinaryContext>>>,
 }
 
 impl Delegation {
@@ -173,6 +627,7 @@ impl Delegation {
         (
             Self {
                 on_bridge_callback: Arc::new(RwLock::new(None)),
+                on_bridge_binary_callback: Arc::new(RwLock::new(None)),
                 observer: Arc::new(observer),
                 tx: Arc::new(tx),
             },
@@ -290,6 +745,35 @@ impl Browser {
             })));
     }
 
+    /// call the `native.bridge.onBinary` handler of the page, the bytes go
+    /// through without any encoding and the page sees an `ArrayBuffer`.
+    /// returns `None` if the page responded with an error.
+    pub async fn call_bridge_binary(&self, req: &[u8]) -> Result<Option<Vec<u8>>, BrowserError> {
+        Bridge::call_binary(self.ptr, req)
+            .await
+            .map_err(|e| BrowserError::BridgeError(e))
+    }
+
+    /// handle `native.bridge.callBinary` from the page.
+    pub fn on_bridge_binary<H>(&self, observer: H)
+    where
+        H: BinaryBridgeObserver + 'static,
+    {
+        let runtime = self.runtime.clone();
+        let observer = Arc::new(observer);
+        let _ = self
+            .delegation
+            .on_bridge_binary_callback
+            .write()
+            .unwrap()
+            .insert(BridgeOnBinaryContext(Arc::new(move |req, callback| {
+                let observer = observer.clone();
+                runtime.spawn(async move {
+                    callback(observer.on(req).await.map_err(|e| e.to_string()));
+                });
+            })));
+    }
+
     pub fn on_mouse(&self, action: MouseAction) {
         Control::on_mouse(self.ptr, action)
     }
@@ -298,6 +782,26 @@ impl Browser {
         Control::on_keyboard(self.ptr, scan_code, state, modifiers)
     }
 
+    /// send input events in one call, they are queued in order. returns how
+    /// many events were queued, when the input queue fills up the rest can be
+    /// sent again later.
+    pub fn on_input_batch(&self, events: &[InputEvent]) -> usize {
+        Control::on_input_batch(self.ptr, events)
+    }
+
+    /// type text into the focused element in one call, runs of text are
+    /// committed like ime input, line breaks and tabs are sent as key presses.
+    pub fn on_text(&self, text: &str) {
+        Control::on_text(self.ptr, text)
+    }
+
+    /// take the caps lock and num lock state from the system. the modifier
+    /// and lock state otherwise follows the key events sent to the browser,
+    /// call this when the host window regains focus.
+    pub fn sync_keyboard_state(&self) {
+        Control::sync_keyboard_state(self.ptr)
+    }
+
     pub fn on_touch(
         &self,
         id: i32,
@@ -317,6 +821,26 @@ impl Browser {
         unsafe { browser_resize(self.ptr, width as c_int, height as c_int) }
     }
 
+    /// change the maximum rate at which frames are painted, with
+    /// `adaptive_frame_rate` enabled this is the upper bound of the rate.
+    pub fn set_frame_rate(&self, frame_rate: u32) {
+        unsafe { browser_set_frame_rate(self.ptr, frame_rate) }
+    }
+
+    /// show or hide the browser, a hidden browser is not rendered at all.
+    /// when it is shown again the whole view is repainted and delivered.
+    pub fn set_visible(&self, is_visible: bool) {
+        unsafe { browser_set_visible(self.ptr, is_visible) }
+    }
+
+    /// ask chromium to produce a frame, only valid with `external_begin_frame`
+    /// enabled. returns the id the resulting frame is tagged with, or 0 if the
+    /// mode is not enabled. a request does not produce a frame if nothing
+    /// changed.
+    pub fn request_frame(&self) -> u64 {
+        unsafe { browser_request_frame(self.ptr) }
+    }
+
     pub fn window_handle(&self) -> HWND {
         HWND(unsafe { browser_get_hwnd(self.ptr) })
     }
@@ -324,6 +848,155 @@ impl Browser {
     pub fn set_devtools_state(&self, is_open: bool) {
         unsafe { browser_set_devtools_state(self.ptr, is_open) }
     }
+
+    /// get the counters of the change filter, returns `None` if the change
+    /// filter is not enabled.
+    pub fn change_filter_stats(&self) -> Option<ChangeFilterStats> {
+        let mut stats = ChangeFilterStats::default();
+        if unsafe { browser_get_change_filter_stats(self.ptr, &mut stats) } {
+            Some(stats)
+        } else {
+            None
+        }
+    }
+
+    /// get the file descriptors of the shared memory frame ring, returns
+    /// `None` if the ring is not enabled or not supported on this platform.
+    ///
+    /// the writer never waits for readers, a reader that falls more than
+    /// `slots - 1` frames behind sees a gap in the sequence numbers and has to
+    /// treat the next frame as fully damaged.
+    pub fn frame_ring(&self) -> Option<FrameRingInfo> {
+        let mut info = FrameRingInfo::default();
+        if unsafe { browser_get_frame_ring(self.ptr, &mut info) } {
+            Some(info)
+        } else {
+            None
+        }
+    }
+
+    /// add a derived output of the painted frames, a region of the view
+    /// downscaled by a box filter. `crop` is in pixels of the painted frame,
+    /// `None` takes the whole view, and `scale` is 1, 2 or 4. only the parts of
+    /// the output under the dirty rects are recomputed, `handler` is called on
+    /// the CEF UI thread with a BGRA frame whenever the output changed.
+    /// returns `None` if `scale` is not supported.
+    pub fn add_output<F>(
+        &self,
+        crop: Option<Rect>,
+        scale: u32,
+        handler: F,
+    ) -> Option<FrameOutput<'_>>
+    where
+        F: Fn(&Frame) + Send + Sync + 'static,
+    {
+        let crop = crop.unwrap_or(Rect {
+            x: 0,
+            y: 0,
+            width: 0,
+            height: 0,
+        });
+
+        let handler: *mut OutputHandler = Box::into_raw(Box::new(Box::new(handler)));
+        let id = unsafe {
+            browser_add_output(self.ptr, crop, scale as c_int, on_output, handler as *mut _)
+        };
+        if id < 0 {
+            drop(unsafe { Box::from_raw(handler) });
+            None
+        } else {
+            Some(FrameOutput {
+                browser: self,
+                id,
+                handler,
+            })
+        }
+    }
+
+    /// take the tiles whose content changed after surface version `since`,
+    /// pass 0 to get all tiles. returns `None` if tiled output is not enabled,
+    /// nothing changed, or the previous set is still held.
+    pub fn acquire_tiles(&self, since: u64) -> Option<TileSetGuard<'_>> {
+        let ptr = unsafe { browser_acquire_tiles(self.ptr, since) };
+        if ptr.is_null() {
+            None
+        } else {
+            Some(TileSetGuard { browser: self, ptr })
+        }
+    }
+
+    /// get the counters and histograms of the render path, with `reset` they
+    /// start over so that every call covers the time since the previous one.
+    pub fn render_stats(&self, reset: bool) -> RenderStats {
+        let mut stats = RenderStats::default();
+        unsafe { browser_get_render_stats(self.ptr, &mut stats, reset) }
+        stats
+    }
+
+    /// get the counters and histograms of the input queue, with `reset` they
+    /// start over.
+    pub fn input_stats(&self, reset: bool) -> InputStats {
+        let mut stats = InputStats::default();
+        unsafe { browser_get_input_stats(self.ptr, &mut stats, reset) }
+        stats
+    }
+
+    /// start recording the painted frames and the input events into `path`,
+    /// a running recording is stopped first. the recording is written on a
+    /// background thread and can be inspected with the webview-replay tool.
+    /// returns false if the file can not be created.
+    pub fn start_recording(&self, path: &str) -> bool {
+        match CStrPtr::try_from(path) {
+            Ok(path) => unsafe { browser_start_recording(self.ptr, path.ptr) },
+            Err(_) => false,
+        }
+    }
+
+    /// start recording only the input into `path`, every mouse, keyboard,
+    /// touch, text and ime call with its timestamp. the log can be played back
+    /// with `Browser::start_replay`, stopped with `Browser::stop_recording`.
+    pub fn start_input_recording(&self, path: &str) -> bool {
+        match CStrPtr::try_from(path) {
+            Ok(path) => unsafe { browser_start_input_recording(self.ptr, path.ptr) },
+            Err(_) => false,
+        }
+    }
+
+    /// stop the recording, returns once every queued frame is written.
+    pub fn stop_recording(&self) {
+        unsafe { browser_stop_recording(self.ptr) }
+    }
+
+    /// play back the input of a recording on a background thread, with
+    /// `is_realtime` the events keep their original timing, otherwise they are
+    /// sent as fast as possible. returns false if the file can not be read.
+    pub fn start_replay(&self, path: &str, is_realtime: bool) -> bool {
+        match CStrPtr::try_from(path) {
+            Ok(path) => unsafe { browser_start_replay(self.ptr, path.ptr, is_realtime) },
+            Err(_) => false,
+        }
+    }
+
+    pub fn stop_replay(&self) {
+        unsafe { browser_stop_replay(self.ptr) }
+    }
+
+    /// true until every event of the replay was sent.
+    pub fn is_replaying(&self) -> bool {
+        unsafe { browser_is_replaying(self.ptr) }
+    }
+
+    /// take the latest frame from the frame store, returns `None` if the
+    /// frame store is not enabled, there is no new frame since the last call,
+    /// or the previous frame is still held.
+    pub fn acquire_frame(&self) -> Option<FrameGuard<'_>> {
+        let ptr = unsafe { browser_acquire_frame(self.ptr) };
+        if ptr.is_null() {
+            None
+        } else {
+            Some(FrameGuard { browser: self, ptr })
+        }
+    }
 }
 
 impl Drop for Browser {
@@ -338,9 +1011,11 @@ static BROWSER_OBSERVER: RawBrowserObserver = RawBrowserObserver {
     on_state_change,
     on_ime_rect,
     on_frame,
+    on_frame_ex,
     on_title_change,
     on_fullscreen_change,
     on_bridge,
+    on_bridge_binary,
 };
 
 extern "C" fn on_state_change(state: BrowserState, ctx: *mut c_void) {
@@ -364,6 +1039,12 @@ extern "C" fn on_frame(texture: *const c_void, width: c_int, height: c_int, ctx:
     );
 }
 
+extern "C" fn on_frame_ex(frame: *const RawFrame, ctx: *mut c_void) {
+    (unsafe { &*(ctx as *mut Delegation) })
+        .observer
+        .on_frame_ex(&Frame::from(unsafe { &*frame }));
+}
+
 extern "C" fn on_title_change(title: *const c_char, ctx: *mut c_void) {
     if let Some(title) = from_c_str(title) {
         (unsafe { &*(ctx as *mut Delegation) })
@@ -413,3 +1094,37 @@ extern "C" fn on_bridge(
             });
     });
 }
+
+extern "C" fn on_bridge_binary(
+    req: *const u8,
+    size: usize,
+    ctx: *mut c_void,
+    callback_ctx: *mut c_void,
+    callback: BridgeBinaryOnCallback,
+) {
+    let req = if size == 0 {
+        Vec::new()
+    } else {
+        unsafe { from_raw_parts(req, size) }.to_vec()
+    };
+
+    let callback_ctx = callback_ctx as usize;
+    let respond = Box::new(move |ret: Result<Vec<u8>, String>| {
+        let (res, is_err) = match ret {
+            Ok(res) => (res, false),
+            Err(err) => (err.into_bytes(), true),
+        };
+
+        callback(callback_ctx as *mut c_void, res.as_ptr(), res.len(), is_err);
+    });
+
+    match (unsafe { &*(ctx as *mut Delegation) })
+        .on_bridge_binary_callback
+        .read()
+        .unwrap()
+        .as_ref()
+    {
+        Some(on_ctx) => on_ctx.0.as_ref()(req, respond),
+        None => respond(Err("runtime not load!".to_string())),
+    }
+}
@@ -11,12 +11,15 @@ use ptr::AsCStr;
 
 pub use app::{App, AppSettings};
 pub use browser::{
-    bridge::BridgeObserver,
+    bridge::{BinaryBridgeObserver, BridgeObserver},
     control::{
-        ActionState, ImeAction, Modifiers, MouseAction, MouseButtons, Position, Rect,
-        TouchEventType, TouchPointerType,
+        ActionState, ImeAction, InputEvent, KeyboardLayout, Modifiers, MouseAction, MouseButtons,
+        Position, Rect, TouchEventType, TouchPointerType,
     },
-    Browser, BrowserSettings, BrowserState, Observer, HWND,
+    Browser, BrowserSettings, BrowserState, ChangeFilterStats, Frame, FrameGuard, FrameOutput,
+    FrameRingHeader, FrameRingInfo, FrameRingSlot, HistogramStats, InputStats, Observer,
+    PixelFormat, RenderStats, Tile, TileSetGuard, FRAME_RING_MAGIC, FRAME_RING_MAX_RECTS,
+    FRAME_RING_VERSION, HWND, TILE_SIZE,
 };
 
 extern "C" {
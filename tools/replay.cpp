@@ -0,0 +1,474 @@
+//
+//  replay.cpp
+//  webview
+//
+//  Created by Mr.Panda on 2023/9/28.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../lib/recording.h"
+
+//
+// Inspect the recordings written by browser_start_recording:
+//
+//   webview-replay info <file>
+//   webview-replay extract <file> <out.png> [--frame N | --time MS]
+//   webview-replay replay <file> <out_dir> [--step N]
+//
+
+typedef struct
+{
+    int64_t offset;
+    uint64_t timestamp;
+    // the frame this frame can be decoded from without earlier records.
+    size_t keyframe;
+} FrameEntry;
+
+static uint32_t crc_table[256];
+
+static void crc_init()
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+        {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void put_chunk(FILE* file, const char* type, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> chunk;
+    put_u32(chunk, (uint32_t)data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    put_u32(chunk, crc_update(0xFFFFFFFFu, chunk.data() + 4, chunk.size() - 4) ^ 0xFFFFFFFFu);
+    fwrite(chunk.data(), chunk.size(), 1, file);
+}
+
+//
+// Write a BGRA canvas as an RGBA png. The image data is stored in
+// uncompressed deflate blocks, the recording is the compact format and the
+// pngs are only meant to be looked at.
+//
+static bool write_png(const char* path, const std::vector<uint8_t>& canvas, int width, int height)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(signature, sizeof(signature), 1, file);
+
+    std::vector<uint8_t> ihdr;
+    put_u32(ihdr, width);
+    put_u32(ihdr, height);
+    // 8 bits per channel, truecolor with alpha, deflate, no filter, no interlace.
+    ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 });
+    put_chunk(file, "IHDR", ihdr);
+
+    std::vector<uint8_t> raw;
+    raw.reserve(((size_t)width * 4 + 1) * height);
+    for (int y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        const uint8_t* row = canvas.data() + (size_t)y * width * 4;
+        for (int x = 0; x < width; x++)
+        {
+            raw.push_back(row[x * 4 + 2]);
+            raw.push_back(row[x * 4 + 1]);
+            raw.push_back(row[x * 4]);
+            raw.push_back(row[x * 4 + 3]);
+        }
+    }
+
+    std::vector<uint8_t> idat = { 0x78, 0x01 };
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (size_t offset = 0; offset < raw.size();)
+    {
+        size_t size = std::min<size_t>(raw.size() - offset, 65535);
+        bool is_last = offset + size == raw.size();
+        idat.push_back(is_last ? 1 : 0);
+        idat.push_back(size & 0xFF);
+        idat.push_back(size >> 8);
+        idat.push_back(~size & 0xFF);
+        idat.push_back((~size >> 8) & 0xFF);
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+        for (size_t i = offset; i < offset + size; i++)
+        {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+
+        offset += size;
+    }
+
+    put_u32(idat, (b << 16) | a);
+    put_chunk(file, "IDAT", idat);
+    put_chunk(file, "IEND", {});
+    return fclose(file) == 0;
+}
+
+static const char* input_name(int32_t type)
+{
+    switch (type)
+    {
+        case kInputMouseClick:
+            return "click";
+        case kInputMouseMove:
+            return "move";
+        case kInputMouseWheel:
+            return "wheel";
+        case kInputKeyboard:
+            return "key";
+        case kInputTouch:
+            return "touch";
+        default:
+            return "unknown";
+    }
+}
+
+static void print_input(const RecordHeader& header, const std::vector<uint8_t>& payload)
+{
+    RecordInput input;
+    if (payload.size() != sizeof(input))
+    {
+        return;
+    }
+
+    memcpy(&input, payload.data(), sizeof(input));
+    printf("%10.3f ms  %-6s x=%d y=%d code=%d flags=%d\n",
+           header.timestamp / 1e6,
+           input_name(input.type),
+           input.x,
+           input.y,
+           input.code,
+           input.flags);
+}
+
+static void print_text(const RecordHeader& header, const std::vector<uint8_t>& payload)
+{
+    RecordText text;
+    if (payload.size() < sizeof(text))
+    {
+        return;
+    }
+
+    memcpy(&text, payload.data(), sizeof(text));
+    if (payload.size() - sizeof(text) < text.size)
+    {
+        return;
+    }
+
+    printf("%10.3f ms  %-6s x=%d y=%d \"%.*s\"\n",
+           header.timestamp / 1e6,
+           text.type == kInputTextCommit ? "commit" : "ime",
+           text.x,
+           text.y,
+           (int)text.size,
+           (const char*)payload.data() + sizeof(text));
+}
+
+static bool build_index(RecordReader& reader, std::vector<FrameEntry>& frames)
+{
+    RecordHeader header;
+    size_t keyframe = SIZE_MAX;
+    for (int64_t offset = reader.Tell(); reader.Next(header, nullptr); offset = reader.Tell())
+    {
+        if (header.type == kRecordKeyframe)
+        {
+            keyframe = frames.size();
+        }
+        else if (header.type != kRecordDelta)
+        {
+            continue;
+        }
+
+        // deltas before the first keyframe can not be decoded.
+        if (keyframe != SIZE_MAX)
+        {
+            frames.push_back({ offset, header.timestamp, keyframe });
+        }
+    }
+
+    return !frames.empty();
+}
+
+static int cmd_info(const char* path)
+{
+    RecordReader reader;
+    if (!reader.Open(path))
+    {
+        fprintf(stderr, "%s: not a recording\n", path);
+        return 1;
+    }
+
+    size_t counts[5] = {};
+    uint64_t bytes[5] = {};
+    uint64_t raw_bytes = 0;
+    uint64_t duration = 0;
+    int width = 0;
+    int height = 0;
+
+    RecordHeader header;
+    std::vector<uint8_t> payload;
+    while (reader.Next(header, &payload))
+    {
+        int type = header.type <= kRecordText ? header.type : 0;
+        counts[type]++;
+        bytes[type] += sizeof(header) + header.size;
+        duration = header.timestamp;
+
+        if (header.type == kRecordInput || header.type == kRecordText)
+        {
+            continue;
+        }
+
+        RecordFrame frame;
+        if (payload.size() < sizeof(frame))
+        {
+            continue;
+        }
+
+        memcpy(&frame, payload.data(), sizeof(frame));
+        width = frame.width;
+        height = frame.height;
+        raw_bytes += (uint64_t)frame.width * frame.height * 4;
+    }
+
+    uint64_t frame_bytes = bytes[kRecordKeyframe] + bytes[kRecordDelta];
+    printf("size:      %dx%d\n", width, height);
+    printf("duration:  %.3f s\n", duration / 1e9);
+    printf("keyframes: %zu (%llu bytes)\n", counts[kRecordKeyframe],
+           (unsigned long long)bytes[kRecordKeyframe]);
+    printf("deltas:    %zu (%llu bytes)\n", counts[kRecordDelta],
+           (unsigned long long)bytes[kRecordDelta]);
+    printf("inputs:    %zu\n", counts[kRecordInput]);
+    printf("texts:     %zu\n", counts[kRecordText]);
+    if (frame_bytes > 0)
+    {
+        printf("ratio:     %.1fx smaller than raw frames\n", (double)raw_bytes / frame_bytes);
+    }
+
+    return 0;
+}
+
+static int cmd_extract(const char* path, const char* output, int64_t frame, int64_t time)
+{
+    RecordReader reader;
+    std::vector<FrameEntry> frames;
+    if (!reader.Open(path) || !build_index(reader, frames))
+    {
+        fprintf(stderr, "%s: no frames\n", path);
+        return 1;
+    }
+
+    // the last frame at or before the time, which is the frame on screen.
+    size_t target = 0;
+    if (time >= 0)
+    {
+        uint64_t timestamp = (uint64_t)time * 1000000;
+        while (target + 1 < frames.size() && frames[target + 1].timestamp <= timestamp)
+        {
+            target++;
+        }
+    }
+    else
+    {
+        target = std::min<size_t>(frame, frames.size() - 1);
+    }
+
+    std::vector<uint8_t> canvas;
+    std::vector<uint8_t> payload;
+    RecordHeader header;
+    int width = 0;
+    int height = 0;
+    for (size_t i = frames[target].keyframe; i <= target; i++)
+    {
+        if (!reader.Seek(frames[i].offset) || !reader.Next(header, &payload) ||
+            !RecordApplyFrame((RecordType)header.type, payload, canvas, width, height))
+        {
+            fprintf(stderr, "%s: corrupt frame %zu\n", path, i);
+            return 1;
+        }
+    }
+
+    if (!write_png(output, canvas, width, height))
+    {
+        fprintf(stderr, "%s: can not write\n", output);
+        return 1;
+    }
+
+    printf("frame %zu at %.3f ms -> %s\n", target, frames[target].timestamp / 1e6, output);
+    return 0;
+}
+
+static int cmd_replay(const char* path, const char* output_dir, int step)
+{
+    RecordReader reader;
+    if (!reader.Open(path))
+    {
+        fprintf(stderr, "%s: not a recording\n", path);
+        return 1;
+    }
+
+    std::vector<uint8_t> canvas;
+    std::vector<uint8_t> payload;
+    RecordHeader header;
+    int width = 0;
+    int height = 0;
+    bool has_keyframe = false;
+    size_t index = 0;
+    while (reader.Next(header, &payload))
+    {
+        if (header.type == kRecordInput)
+        {
+            print_input(header, payload);
+            continue;
+        }
+
+        if (header.type == kRecordText)
+        {
+            print_text(header, payload);
+            continue;
+        }
+
+        if (header.type != kRecordKeyframe && header.type != kRecordDelta)
+        {
+            continue;
+        }
+
+        has_keyframe |= header.type == kRecordKeyframe;
+        if (!has_keyframe)
+        {
+            continue;
+        }
+
+        if (!RecordApplyFrame((RecordType)header.type, payload, canvas, width, height))
+        {
+            fprintf(stderr, "%s: corrupt frame %zu\n", path, index);
+            return 1;
+        }
+
+        if (index % step == 0)
+        {
+            std::string name = std::string(output_dir) + "/frame_";
+            char number[32];
+            snprintf(number, sizeof(number), "%06zu.png", index);
+            name += number;
+
+            if (!write_png(name.c_str(), canvas, width, height))
+            {
+                fprintf(stderr, "%s: can not write\n", name.c_str());
+                return 1;
+            }
+
+            printf("%10.3f ms  frame %zu -> %s\n", header.timestamp / 1e6, index, name.c_str());
+        }
+
+        index++;
+    }
+
+    return 0;
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: webview-replay info <file>\n"
+            "       webview-replay extract <file> <out.png> [--frame N | --time MS]\n"
+            "       webview-replay replay <file> <out_dir> [--step N]\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        usage();
+        return 2;
+    }
+
+    crc_init();
+
+    std::string command = argv[1];
+    if (command == "info")
+    {
+        return cmd_info(argv[2]);
+    }
+
+    if (argc < 4)
+    {
+        usage();
+        return 2;
+    }
+
+    int64_t frame = 0;
+    int64_t time = -1;
+    int step = 1;
+    for (int i = 4; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--frame")
+        {
+            frame = atoll(argv[i + 1]);
+        }
+        else if (option == "--time")
+        {
+            time = atoll(argv[i + 1]);
+        }
+        else if (option == "--step")
+        {
+            step = std::max(atoi(argv[i + 1]), 1);
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    if (command == "extract")
+    {
+        return cmd_extract(argv[2], argv[3], std::max<int64_t>(frame, 0), time);
+    }
+    else if (command == "replay")
+    {
+        return cmd_replay(argv[2], argv[3], step);
+    }
+
+    usage();
+    return 2;
+}